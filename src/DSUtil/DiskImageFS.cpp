@@ -0,0 +1,1026 @@
+/*
+ * (C) 2026 see Authors.txt
+ *
+ * This file is part of MPC-BE.
+ *
+ * MPC-BE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MPC-BE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "stdafx.h"
+#include <mpc_defines.h>
+#include "Log.h"
+#include "DiskImageFS.h"
+
+#define SECTOR_SIZE        2048
+#define MAX_DIRECTORY_SIZE (64 * MEGABYTE)
+#define MAX_AD_DEPTH       32
+
+#define READAHEAD_SIZE     (4 * MEGABYTE)
+#define READAHEAD_ALIGN    (64 * KILOBYTE)
+
+// UDF descriptor tags (ECMA-167)
+enum {
+	UDF_TAG_AnchorVolumeDescriptor  = 0x0002,
+	UDF_TAG_PartitionDescriptor     = 0x0005,
+	UDF_TAG_LogicalVolumeDescriptor = 0x0006,
+	UDF_TAG_TerminatingDescriptor   = 0x0008,
+	UDF_TAG_FileSetDescriptor       = 0x0100,
+	UDF_TAG_FileIdentifier          = 0x0101,
+	UDF_TAG_AllocationExtent        = 0x0102,
+	UDF_TAG_FileEntry               = 0x0105,
+	UDF_TAG_ExtendedFileEntry       = 0x010A,
+};
+
+#define UDF_FT_Directory       4
+#define UDF_FID_Deleted        0x04
+#define UDF_FID_Parent         0x08
+#define UDF_AD_InICB           3
+
+static inline WORD  GetLE16(const BYTE* p) { return *(const WORD*)p; }
+static inline DWORD GetLE32(const BYTE* p) { return *(const DWORD*)p; }
+static inline ULONGLONG GetLE64(const BYTE* p) { return *(const ULONGLONG*)p; }
+
+static CStringW NormalizeInnerPath(LPCWSTR innerPath)
+{
+	CStringW path(innerPath);
+	path.Replace(L'/', L'\\');
+	path.Trim(L'\\');
+
+	return path;
+}
+
+static void AddExtent(std::vector<CDiskImageFS::Extent>& extents, const CDiskImageFS::Extent& ext)
+{
+	if (!extents.empty()) {
+		auto& last = extents.back();
+		if (last.sparse == ext.sparse && (ext.sparse || last.offset + last.length == ext.offset)) {
+			last.length += ext.length;
+			return;
+		}
+	}
+
+	extents.emplace_back(ext);
+}
+
+// OSTA Compressed Unicode (UDF 2.1.1)
+static CStringW UDFDecodeName(const BYTE* data, DWORD len)
+{
+	CStringW name;
+	if (len < 2) {
+		return name;
+	}
+
+	if (data[0] == 8) {
+		for (DWORD i = 1; i < len; i++) {
+			name.AppendChar((WCHAR)data[i]);
+		}
+	} else if (data[0] == 16) {
+		for (DWORD i = 1; i + 1 < len; i += 2) {
+			name.AppendChar((WCHAR)((data[i] << 8) | data[i + 1]));
+		}
+	}
+
+	return name;
+}
+
+//
+// CDiskImageFS
+//
+
+CDiskImageFS::CDiskImageFS() = default;
+
+CDiskImageFS::~CDiskImageFS()
+{
+	Close();
+}
+
+bool CDiskImageFS::Open(LPCWSTR imagePath)
+{
+	Close();
+
+	m_hImage = CreateFileW(imagePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+						   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_hImage == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(m_hImage, &size) || size.QuadPart < 32 * SECTOR_SIZE) {
+		Close();
+		return false;
+	}
+	m_imageSize = size.QuadPart;
+
+	if (OpenUDF()) {
+		m_type = FS_UDF;
+	} else if (OpenISO9660()) {
+		m_type = FS_ISO9660;
+	} else {
+		Close();
+		return false;
+	}
+
+	DLog(L"CDiskImageFS::Open() : '%s', %s", imagePath, m_type == FS_UDF ? L"UDF" : m_bJoliet ? L"ISO9660/Joliet" : L"ISO9660");
+
+	return true;
+}
+
+void CDiskImageFS::Close()
+{
+	if (m_hImage != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_hImage);
+		m_hImage = INVALID_HANDLE_VALUE;
+	}
+
+	m_imageSize = 0;
+	m_type = FS_NONE;
+	m_blockSize = SECTOR_SIZE;
+	m_partitions.clear();
+	m_root = {};
+	m_bJoliet = false;
+
+	std::unique_lock<std::mutex> lock(m_mutexDirs);
+	m_dirs.clear();
+}
+
+bool CDiskImageFS::ReadImage(ULONGLONG offset, void* buffer, DWORD length)
+{
+	if (m_hImage == INVALID_HANDLE_VALUE || offset + length > m_imageSize) {
+		return false;
+	}
+
+	// positional read on a synchronous handle, safe to call from several threads
+	OVERLAPPED ov = {};
+	ov.Offset     = (DWORD)offset;
+	ov.OffsetHigh = (DWORD)(offset >> 32);
+
+	DWORD dwRead = 0;
+	return ReadFile(m_hImage, buffer, length, &dwRead, &ov) && dwRead == length;
+}
+
+bool CDiskImageFS::ReadBlocks(ULONGLONG offset, std::vector<BYTE>& data, DWORD length)
+{
+	data.resize(length);
+	return ReadImage(offset, data.data(), length);
+}
+
+bool CDiskImageFS::ReadEntryData(const Entry& entry, std::vector<BYTE>& data)
+{
+	if (entry.size > MAX_DIRECTORY_SIZE) {
+		return false;
+	}
+
+	data.resize((size_t)entry.size);
+
+	size_t pos = 0;
+	for (const auto& ext : entry.extents) {
+		if (pos >= data.size()) {
+			break;
+		}
+
+		const DWORD len = (DWORD)std::min<ULONGLONG>(ext.length, data.size() - pos);
+		if (ext.sparse) {
+			memset(data.data() + pos, 0, len);
+		} else if (!ReadImage(ext.offset, data.data() + pos, len)) {
+			return false;
+		}
+		pos += len;
+	}
+
+	data.resize(pos);
+	return true;
+}
+
+//
+// UDF
+//
+
+bool CDiskImageFS::OpenUDF()
+{
+	std::vector<BYTE> sector;
+
+	// Anchor Volume Descriptor Pointer at 256, N - 256 or N
+	const DWORD lastSector = (DWORD)(m_imageSize / SECTOR_SIZE) - 1;
+	const DWORD anchors[] = { 256, lastSector - 256, lastSector };
+
+	bool bAnchor = false;
+	for (const auto& anchor : anchors) {
+		if (ReadBlocks((ULONGLONG)anchor * SECTOR_SIZE, sector, SECTOR_SIZE)
+				&& GetLE16(&sector[0]) == UDF_TAG_AnchorVolumeDescriptor && GetLE32(&sector[12]) == anchor) {
+			bAnchor = true;
+			break;
+		}
+	}
+	if (!bAnchor) {
+		return false;
+	}
+
+	const DWORD sequences[2][2] = {
+		{ GetLE32(&sector[20]), GetLE32(&sector[16]) }, // Main Volume Descriptor Sequence
+		{ GetLE32(&sector[28]), GetLE32(&sector[24]) }  // Reserve Volume Descriptor Sequence
+	};
+
+	struct PartitionMap {
+		BYTE  type = 0;
+		WORD  number = 0;
+		bool  bMetadata = false;
+		DWORD metadataFile = 0;
+		DWORD metadataMirrorFile = 0;
+	};
+
+	std::map<WORD, DWORD>     partitionStarts; // PartitionNumber -> PartitionStartingLocation
+	std::vector<PartitionMap> maps;
+	WORD                      fsdPartRef = 0;
+	DWORD                     fsdBlock = 0;
+	bool                      bLVD = false;
+
+	for (const auto& seq : sequences) {
+		const DWORD count = std::min<DWORD>(seq[1] / SECTOR_SIZE, 256);
+		for (DWORD i = 0; i < count; i++) {
+			if (!ReadBlocks((ULONGLONG)(seq[0] + i) * SECTOR_SIZE, sector, SECTOR_SIZE)) {
+				break;
+			}
+
+			const WORD tag = GetLE16(&sector[0]);
+			if (tag == UDF_TAG_TerminatingDescriptor) {
+				break;
+			}
+
+			if (tag == UDF_TAG_PartitionDescriptor) {
+				partitionStarts[GetLE16(&sector[22])] = GetLE32(&sector[188]);
+			} else if (tag == UDF_TAG_LogicalVolumeDescriptor && !bLVD) {
+				m_blockSize = GetLE32(&sector[212]);
+				if (m_blockSize != SECTOR_SIZE) {
+					return false;
+				}
+
+				// LogicalVolumeContentsUse contains the File Set Descriptor long_ad
+				fsdBlock   = GetLE32(&sector[252]);
+				fsdPartRef = GetLE16(&sector[256]);
+
+				const DWORD mapTableLength = std::min<DWORD>(GetLE32(&sector[264]), SECTOR_SIZE - 440);
+				const DWORD numberOfMaps   = GetLE32(&sector[268]);
+
+				DWORD pos = 440;
+				for (DWORD m = 0; m < numberOfMaps && pos + 2 <= 440 + mapTableLength; m++) {
+					const BYTE* pm = &sector[pos];
+					const BYTE len = pm[1];
+					if (len < 6 || pos + len > 440 + mapTableLength) {
+						break;
+					}
+
+					PartitionMap map;
+					map.type = pm[0];
+					if (map.type == 1) {
+						map.number = GetLE16(pm + 4);
+					} else if (map.type == 2 && len >= 64) {
+						map.number = GetLE16(pm + 38);
+						if (!memcmp(pm + 5, "*UDF Metadata Partition", 23)) {
+							map.bMetadata          = true;
+							map.metadataFile       = GetLE32(pm + 40);
+							map.metadataMirrorFile = GetLE32(pm + 44);
+						} else if (!memcmp(pm + 5, "*UDF Virtual Partition", 22)) {
+							// VAT is used only on write-once media, not supported
+							return false;
+						}
+						// "*UDF Sparable Partition" is read as a plain physical partition
+					} else {
+						return false;
+					}
+					maps.emplace_back(map);
+
+					pos += len;
+				}
+
+				bLVD = true;
+			}
+		}
+
+		if (bLVD && !partitionStarts.empty()) {
+			break;
+		}
+	}
+
+	if (!bLVD || maps.empty() || partitionStarts.empty()) {
+		return false;
+	}
+
+	m_partitions.resize(maps.size());
+	for (size_t i = 0; i < maps.size(); i++) {
+		const auto it = partitionStarts.find(maps[i].number);
+		if (it == partitionStarts.end()) {
+			return false;
+		}
+		m_partitions[i].number = maps[i].number;
+		m_partitions[i].start  = it->second;
+	}
+
+	// the metadata partition (UDF 2.50+) is addressed through the extents of the metadata file
+	for (size_t i = 0; i < maps.size(); i++) {
+		if (!maps[i].bMetadata) {
+			continue;
+		}
+
+		// the metadata file is recorded in the physical partition with the same number
+		WORD physRef = (WORD)-1;
+		for (size_t j = 0; j < maps.size(); j++) {
+			if (!maps[j].bMetadata && maps[j].number == maps[i].number) {
+				physRef = (WORD)j;
+				break;
+			}
+		}
+		if (physRef == (WORD)-1) {
+			return false;
+		}
+
+		Entry metadata;
+		if (!UDFReadFileEntry(physRef, maps[i].metadataFile, metadata)
+				&& !UDFReadFileEntry(physRef, maps[i].metadataMirrorFile, metadata)) {
+			return false;
+		}
+
+		m_partitions[i].bMetadata       = true;
+		m_partitions[i].metadataExtents = std::move(metadata.extents);
+	}
+
+	// File Set Descriptor
+	ULONGLONG offset = 0;
+	if (!UDFMapBlock(fsdPartRef, fsdBlock, offset)
+			|| !ReadBlocks(offset, sector, SECTOR_SIZE)
+			|| GetLE16(&sector[0]) != UDF_TAG_FileSetDescriptor) {
+		return false;
+	}
+
+	const DWORD rootBlock   = GetLE32(&sector[404]);
+	const WORD  rootPartRef = GetLE16(&sector[408]);
+
+	if (!UDFReadFileEntry(rootPartRef, rootBlock, m_root) || !m_root.bDirectory) {
+		m_partitions.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool CDiskImageFS::UDFMapBlock(WORD partRef, DWORD block, ULONGLONG& offset)
+{
+	if (partRef >= m_partitions.size()) {
+		return false;
+	}
+
+	const auto& part = m_partitions[partRef];
+	if (!part.bMetadata) {
+		offset = ((ULONGLONG)part.start + block) * m_blockSize;
+		return offset < m_imageSize;
+	}
+
+	ULONGLONG pos = (ULONGLONG)block * m_blockSize;
+	for (const auto& ext : part.metadataExtents) {
+		if (pos < ext.length) {
+			if (ext.sparse) {
+				return false;
+			}
+			offset = ext.offset + pos;
+			return true;
+		}
+		pos -= ext.length;
+	}
+
+	return false;
+}
+
+bool CDiskImageFS::UDFMapExtent(WORD partRef, DWORD block, ULONGLONG length, std::vector<Extent>& extents)
+{
+	if (partRef >= m_partitions.size()) {
+		return false;
+	}
+
+	const auto& part = m_partitions[partRef];
+	if (!part.bMetadata) {
+		Extent ext;
+		ext.offset = ((ULONGLONG)part.start + block) * m_blockSize;
+		ext.length = length;
+		AddExtent(extents, ext);
+		return true;
+	}
+
+	// a logical extent of the metadata partition may span several extents of the metadata file
+	ULONGLONG pos = (ULONGLONG)block * m_blockSize;
+	for (const auto& mext : part.metadataExtents) {
+		if (length == 0) {
+			break;
+		}
+		if (pos >= mext.length) {
+			pos -= mext.length;
+			continue;
+		}
+
+		Extent ext;
+		ext.sparse = mext.sparse;
+		ext.offset = mext.offset + pos;
+		ext.length = std::min(length, mext.length - pos);
+		AddExtent(extents, ext);
+
+		length -= ext.length;
+		pos = 0;
+	}
+
+	return length == 0;
+}
+
+bool CDiskImageFS::UDFReadFileEntry(WORD partRef, DWORD block, Entry& entry, int depth/* = 0*/)
+{
+	ULONGLONG offset = 0;
+	std::vector<BYTE> sector;
+	if (!UDFMapBlock(partRef, block, offset) || !ReadBlocks(offset, sector, m_blockSize)) {
+		return false;
+	}
+
+	const WORD tag = GetLE16(&sector[0]);
+	DWORD base = 0, lengthEA = 0, lengthAD = 0;
+	if (tag == UDF_TAG_FileEntry) {
+		lengthEA = GetLE32(&sector[168]);
+		lengthAD = GetLE32(&sector[172]);
+		base     = 176;
+	} else if (tag == UDF_TAG_ExtendedFileEntry) {
+		lengthEA = GetLE32(&sector[208]);
+		lengthAD = GetLE32(&sector[212]);
+		base     = 216;
+	} else {
+		return false;
+	}
+
+	if (base + lengthEA + lengthAD > m_blockSize) {
+		return false;
+	}
+
+	entry.bDirectory = sector[16 + 11] == UDF_FT_Directory;
+	entry.size       = GetLE64(&sector[56]);
+	entry.extents.clear();
+
+	const int adType = GetLE16(&sector[16 + 18]) & 0x7;
+	if (adType == UDF_AD_InICB) {
+		// the file data is embedded in the File Entry itself
+		Extent ext;
+		ext.offset = offset + base + lengthEA;
+		ext.length = lengthAD;
+		entry.extents.emplace_back(ext);
+		entry.size = std::min<ULONGLONG>(entry.size, lengthAD);
+		return true;
+	}
+
+	return UDFParseAllocation(&sector[base + lengthEA], lengthAD, adType, partRef, entry.extents, depth);
+}
+
+bool CDiskImageFS::UDFParseAllocation(const BYTE* ad, DWORD len, int adType, WORD partRef, std::vector<Extent>& extents, int depth)
+{
+	if (depth > MAX_AD_DEPTH) {
+		return false;
+	}
+
+	const DWORD adSize = adType == 0 ? 8 : adType == 1 ? 16 : adType == 2 ? 20 : 0;
+	if (!adSize) {
+		return false;
+	}
+
+	for (DWORD pos = 0; pos + adSize <= len; pos += adSize) {
+		const BYTE* p = ad + pos;
+
+		const DWORD extLength = GetLE32(p) & 0x3FFFFFFF;
+		const DWORD extType   = GetLE32(p) >> 30;
+		if (extLength == 0) {
+			break;
+		}
+
+		DWORD block = 0;
+		WORD  ref   = partRef;
+		switch (adType) {
+			case 0: // short_ad
+				block = GetLE32(p + 4);
+				break;
+			case 1: // long_ad
+				block = GetLE32(p + 4);
+				ref   = GetLE16(p + 8);
+				break;
+			case 2: // ext_ad
+				block = GetLE32(p + 12);
+				ref   = GetLE16(p + 16);
+				break;
+		}
+
+		if (extType == 3) {
+			// continuation in an Allocation Extent Descriptor
+			ULONGLONG offset = 0;
+			std::vector<BYTE> sector;
+			if (!UDFMapBlock(ref, block, offset) || !ReadBlocks(offset, sector, m_blockSize)
+					|| GetLE16(&sector[0]) != UDF_TAG_AllocationExtent) {
+				return false;
+			}
+
+			const DWORD aedLength = std::min<DWORD>(GetLE32(&sector[20]), m_blockSize - 24);
+			return UDFParseAllocation(&sector[24], aedLength, adType, ref, extents, depth + 1);
+		}
+
+		if (extType == 0) {
+			if (!UDFMapExtent(ref, block, extLength, extents)) {
+				return false;
+			}
+		} else {
+			// allocated or unallocated but not recorded
+			Extent ext;
+			ext.length = extLength;
+			ext.sparse = true;
+			AddExtent(extents, ext);
+		}
+	}
+
+	return true;
+}
+
+bool CDiskImageFS::UDFReadDirectory(const Entry& dir, std::vector<Entry>& entries)
+{
+	std::vector<BYTE> data;
+	if (!ReadEntryData(dir, data)) {
+		return false;
+	}
+
+	size_t pos = 0;
+	while (pos + 38 <= data.size()) {
+		const BYTE* fid = &data[pos];
+		if (GetLE16(fid) != UDF_TAG_FileIdentifier) {
+			break;
+		}
+
+		const BYTE  characteristics = fid[18];
+		const BYTE  lengthFI        = fid[19];
+		const DWORD icbBlock        = GetLE32(fid + 24);
+		const WORD  icbPartRef      = GetLE16(fid + 28);
+		const WORD  lengthIU        = GetLE16(fid + 36);
+
+		const size_t fidSize = (38 + lengthIU + lengthFI + 3) & ~3;
+		if (pos + 38 + lengthIU + lengthFI > data.size()) {
+			break;
+		}
+
+		if (!(characteristics & (UDF_FID_Parent | UDF_FID_Deleted)) && lengthFI) {
+			Entry entry;
+			if (UDFReadFileEntry(icbPartRef, icbBlock, entry)) {
+				entry.name = UDFDecodeName(fid + 38 + lengthIU, lengthFI);
+				if (!entry.name.IsEmpty()) {
+					entries.emplace_back(std::move(entry));
+				}
+			}
+		}
+
+		pos += fidSize;
+	}
+
+	return true;
+}
+
+//
+// ISO9660
+//
+
+bool CDiskImageFS::OpenISO9660()
+{
+	std::vector<BYTE> sector;
+
+	bool bPrimary = false;
+	for (DWORD lba = 16; lba < 16 + 32; lba++) {
+		if (!ReadBlocks((ULONGLONG)lba * SECTOR_SIZE, sector, SECTOR_SIZE) || memcmp(&sector[1], "CD001", 5)) {
+			break;
+		}
+
+		const BYTE type = sector[0];
+		if (type == 255) {
+			break;
+		}
+
+		const bool bJoliet = type == 2 && sector[88] == '%' && sector[89] == '/'
+							 && (sector[90] == '@' || sector[90] == 'C' || sector[90] == 'E');
+		if ((type == 1 && !bPrimary && !m_bJoliet) || bJoliet) {
+			m_blockSize = GetLE16(&sector[128]);
+			if (m_blockSize != SECTOR_SIZE) {
+				return false;
+			}
+
+			const BYTE* root = &sector[156];
+			Extent ext;
+			ext.offset = (ULONGLONG)GetLE32(root + 2) * m_blockSize;
+			ext.length = GetLE32(root + 10);
+
+			m_root = {};
+			m_root.bDirectory = true;
+			m_root.size       = ext.length;
+			m_root.extents.emplace_back(ext);
+
+			bPrimary = true;
+			m_bJoliet = bJoliet;
+		}
+	}
+
+	return bPrimary;
+}
+
+bool CDiskImageFS::ISOReadDirectory(const Entry& dir, std::vector<Entry>& entries)
+{
+	std::vector<BYTE> data;
+	if (!ReadEntryData(dir, data)) {
+		return false;
+	}
+
+	bool bPrevMultiExtent = false;
+
+	size_t pos = 0;
+	while (pos < data.size()) {
+		const BYTE len = data[pos];
+		if (len == 0) {
+			// records do not cross the sector boundary
+			pos = (pos / m_blockSize + 1) * m_blockSize;
+			continue;
+		}
+		if (len < 34 || pos + len > data.size()) {
+			break;
+		}
+
+		const BYTE* rec    = &data[pos];
+		const BYTE  flags  = rec[25];
+		const BYTE  lenName = rec[32];
+		pos += len;
+
+		if (33 + lenName > len || (lenName == 1 && (rec[33] == 0 || rec[33] == 1))) {
+			continue;
+		}
+
+		CStringW name;
+		if (m_bJoliet) {
+			for (BYTE i = 0; i + 1 < lenName; i += 2) {
+				name.AppendChar((WCHAR)((rec[33 + i] << 8) | rec[34 + i]));
+			}
+		} else {
+			for (BYTE i = 0; i < lenName; i++) {
+				name.AppendChar((WCHAR)rec[33 + i]);
+			}
+		}
+
+		const int ver = name.Find(L';');
+		if (ver >= 0) {
+			name.Truncate(ver);
+		}
+		name.TrimRight(L'.');
+
+		Extent ext;
+		ext.offset = (ULONGLONG)GetLE32(rec + 2) * m_blockSize;
+		ext.length = GetLE32(rec + 10);
+
+		if (bPrevMultiExtent && !entries.empty() && entries.back().name == name) {
+			// files larger than 4 GB are recorded as several records with the same name
+			auto& entry = entries.back();
+			AddExtent(entry.extents, ext);
+			entry.size += ext.length;
+		} else {
+			Entry entry;
+			entry.name       = name;
+			entry.bDirectory = (flags & 0x02) != 0;
+			entry.size       = ext.length;
+			entry.extents.emplace_back(ext);
+			entries.emplace_back(std::move(entry));
+		}
+
+		bPrevMultiExtent = (flags & 0x80) != 0;
+	}
+
+	return true;
+}
+
+//
+// Lookup
+//
+
+bool CDiskImageFS::GetDirectory(const CStringW& innerPath, std::vector<Entry>& entries)
+{
+	const CStringW key = CStringW(innerPath).MakeUpper();
+	{
+		std::unique_lock<std::mutex> lock(m_mutexDirs);
+		const auto it = m_dirs.find(key);
+		if (it != m_dirs.end()) {
+			entries = it->second;
+			return true;
+		}
+	}
+
+	Entry dir;
+	if (innerPath.IsEmpty()) {
+		dir = m_root;
+	} else if (!FindEntry(innerPath, dir) || !dir.bDirectory) {
+		return false;
+	}
+
+	entries.clear();
+	const bool ret = m_type == FS_UDF ? UDFReadDirectory(dir, entries) : ISOReadDirectory(dir, entries);
+	if (ret) {
+		std::unique_lock<std::mutex> lock(m_mutexDirs);
+		m_dirs[key] = entries;
+	}
+
+	return ret;
+}
+
+bool CDiskImageFS::FindEntry(LPCWSTR innerPath, Entry& entry)
+{
+	if (m_type == FS_NONE) {
+		return false;
+	}
+
+	const CStringW path = NormalizeInnerPath(innerPath);
+	if (path.IsEmpty()) {
+		entry = m_root;
+		return true;
+	}
+
+	const int slash = path.ReverseFind(L'\\');
+	const CStringW parent = slash > 0 ? path.Left(slash) : CStringW();
+	const CStringW name   = path.Mid(slash + 1);
+
+	std::vector<Entry> entries;
+	if (!GetDirectory(parent, entries)) {
+		return false;
+	}
+
+	for (auto& e : entries) {
+		if (e.name.CompareNoCase(name) == 0) {
+			entry = std::move(e);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool CDiskImageFS::ReadDirectory(LPCWSTR innerPath, std::vector<Entry>& entries)
+{
+	if (m_type == FS_NONE) {
+		return false;
+	}
+
+	return GetDirectory(NormalizeInnerPath(innerPath), entries);
+}
+
+//
+// Image path helpers
+//
+
+bool CDiskImageFS::SplitPath(LPCWSTR path, CStringW& imagePath, CStringW& innerPath)
+{
+	const CStringW str(path);
+	const CStringW lower = CStringW(path).MakeLower();
+
+	int pos = 0;
+	while ((pos = lower.Find(L".iso\\", pos)) > 0) {
+		const CStringW image = str.Left(pos + 4);
+		const DWORD attr = GetFileAttributesW(image);
+		if (attr != INVALID_FILE_ATTRIBUTES && !(attr & FILE_ATTRIBUTE_DIRECTORY)) {
+			imagePath = image;
+			innerPath = str.Mid(pos + 5);
+			return true;
+		}
+		pos += 5;
+	}
+
+	return false;
+}
+
+bool CDiskImageFS::IsImagePath(LPCWSTR path)
+{
+	CStringW imagePath, innerPath;
+	return SplitPath(path, imagePath, innerPath);
+}
+
+std::shared_ptr<CDiskImageFS> CDiskImageFS::GetImage(LPCWSTR imagePath)
+{
+	struct CacheEntry {
+		std::shared_ptr<CDiskImageFS> image;
+		ULONGLONG                     size  = 0;
+		ULONGLONG                     mtime = 0;
+	};
+	static std::mutex s_mutex;
+	static std::map<CStringW, CacheEntry> s_images;
+
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	if (!GetFileAttributesExW(imagePath, GetFileExInfoStandard, &fad)) {
+		return nullptr;
+	}
+	const ULONGLONG size  = ((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+	const ULONGLONG mtime = ((ULONGLONG)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime;
+
+	const CStringW key = CStringW(imagePath).MakeUpper();
+
+	std::unique_lock<std::mutex> lock(s_mutex);
+	const auto it = s_images.find(key);
+	if (it != s_images.end() && it->second.size == size && it->second.mtime == mtime) {
+		return it->second.image;
+	}
+
+	auto image = std::make_shared<CDiskImageFS>();
+	if (!image->Open(imagePath)) {
+		return nullptr;
+	}
+
+	if (s_images.size() >= 4) {
+		s_images.clear();
+	}
+	s_images[key] = { image, size, mtime };
+
+	return image;
+}
+
+bool CDiskImageFS::GetEntry(LPCWSTR path, Entry& entry)
+{
+	CStringW imagePath, innerPath;
+	if (!SplitPath(path, imagePath, innerPath)) {
+		return false;
+	}
+
+	const auto image = GetImage(imagePath);
+	return image && image->FindEntry(innerPath, entry);
+}
+
+bool CDiskImageFS::FileExists(LPCWSTR path)
+{
+	Entry entry;
+	return GetEntry(path, entry) && !entry.bDirectory;
+}
+
+bool CDiskImageFS::DirectoryExists(LPCWSTR path)
+{
+	Entry entry;
+	return GetEntry(path, entry) && entry.bDirectory;
+}
+
+bool CDiskImageFS::ListDirectory(LPCWSTR path, std::vector<Entry>& entries)
+{
+	CStringW imagePath, innerPath;
+	if (!SplitPath(path, imagePath, innerPath)) {
+		return false;
+	}
+
+	const auto image = GetImage(imagePath);
+	return image && image->ReadDirectory(innerPath, entries);
+}
+
+bool CDiskImageFS::ReadWholeFile(LPCWSTR path, std::vector<BYTE>& data, size_t maxSize)
+{
+	CDiskImageFile file;
+	if (!file.Open(path) || file.GetLength() > maxSize) {
+		return false;
+	}
+
+	data.resize((size_t)file.GetLength());
+	return file.Read(data.data(), (DWORD)data.size()) == data.size();
+}
+
+//
+// CDiskImageFile
+//
+
+CDiskImageFile::CDiskImageFile() = default;
+
+CDiskImageFile::~CDiskImageFile()
+{
+	Close();
+}
+
+bool CDiskImageFile::Open(LPCWSTR path)
+{
+	Close();
+
+	CStringW imagePath, innerPath;
+	if (!CDiskImageFS::SplitPath(path, imagePath, innerPath)) {
+		return false;
+	}
+
+	auto image = CDiskImageFS::GetImage(imagePath);
+	if (!image || !image->FindEntry(innerPath, m_entry) || m_entry.bDirectory) {
+		m_entry = {};
+		return false;
+	}
+
+	m_pImage = std::move(image);
+	return true;
+}
+
+void CDiskImageFile::Close()
+{
+	m_pImage.reset();
+	m_entry = {};
+	m_pos = 0;
+	m_cache.clear();
+	m_cacheStart = 0;
+	m_cacheSize = 0;
+}
+
+ULONGLONG CDiskImageFile::Seek(LONGLONG offset, DWORD moveMethod)
+{
+	LONGLONG pos = offset;
+	if (moveMethod == FILE_CURRENT) {
+		pos += (LONGLONG)m_pos;
+	} else if (moveMethod == FILE_END) {
+		pos += (LONGLONG)m_entry.size;
+	}
+
+	m_pos = (ULONGLONG)std::max(pos, 0LL);
+
+	return m_pos;
+}
+
+DWORD CDiskImageFile::Read(void* buffer, DWORD length)
+{
+	if (!m_pImage || m_pos >= m_entry.size) {
+		return 0;
+	}
+
+	length = (DWORD)std::min<ULONGLONG>(length, m_entry.size - m_pos);
+
+	BYTE* ptr = (BYTE*)buffer;
+	DWORD left = length;
+	while (left) {
+		if (m_pos >= m_cacheStart && m_pos < m_cacheStart + m_cacheSize) {
+			const DWORD size = (DWORD)std::min<ULONGLONG>(left, m_cacheStart + m_cacheSize - m_pos);
+			memcpy(ptr, m_cache.data() + (m_pos - m_cacheStart), size);
+			ptr   += size;
+			left  -= size;
+			m_pos += size;
+		} else if (left >= READAHEAD_SIZE) {
+			// large requests go directly to the image
+			if (!ReadAt(m_pos, ptr, left)) {
+				break;
+			}
+			ptr   += left;
+			m_pos += left;
+			left   = 0;
+		} else if (!FillCache(m_pos)) {
+			break;
+		}
+	}
+
+	return length - left;
+}
+
+bool CDiskImageFile::FillCache(ULONGLONG pos)
+{
+	m_cacheStart = pos & ~(ULONGLONG)(READAHEAD_ALIGN - 1);
+	m_cacheSize  = (DWORD)std::min<ULONGLONG>(READAHEAD_SIZE, m_entry.size - m_cacheStart);
+	m_cache.resize(READAHEAD_SIZE);
+
+	if (!ReadAt(m_cacheStart, m_cache.data(), m_cacheSize)) {
+		m_cacheSize = 0;
+		return false;
+	}
+
+	return true;
+}
+
+bool CDiskImageFile::ReadAt(ULONGLONG pos, BYTE* buffer, DWORD length)
+{
+	ULONGLONG extStart = 0;
+	for (const auto& ext : m_entry.extents) {
+		if (!length) {
+			break;
+		}
+
+		if (pos < extStart + ext.length) {
+			const ULONGLONG offset = pos - extStart;
+			const DWORD size = (DWORD)std::min<ULONGLONG>(length, ext.length - offset);
+			if (ext.sparse) {
+				memset(buffer, 0, size);
+			} else if (!m_pImage->ReadImage(ext.offset + offset, buffer, size)) {
+				return false;
+			}
+
+			buffer += size;
+			pos    += size;
+			length -= size;
+		}
+
+		extStart += ext.length;
+	}
+
+	if (length) {
+		memset(buffer, 0, length);
+	}
+
+	return true;
+}
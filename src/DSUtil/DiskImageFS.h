@@ -0,0 +1,155 @@
+/*
+ * (C) 2026 see Authors.txt
+ *
+ * This file is part of MPC-BE.
+ *
+ * MPC-BE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MPC-BE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+
+//
+// User-space reader for UDF 1.02-2.60 and ISO9660 (with Joliet) disc images.
+//
+// A file inside an image is addressed by appending its path to the image path,
+// e.g. "D:\Movies\Disc.iso\BDMV\PLAYLIST\00800.mpls".
+//
+
+class CDiskImageFS
+{
+public:
+	struct Extent {
+		ULONGLONG offset = 0; // byte offset in the image
+		ULONGLONG length = 0;
+		bool      sparse = false; // allocated but not recorded, reads as zeroes
+	};
+
+	struct Entry {
+		CStringW            name;
+		bool                bDirectory = false;
+		ULONGLONG           size       = 0;
+		std::vector<Extent> extents;
+	};
+
+	enum FSType {
+		FS_NONE,
+		FS_UDF,
+		FS_ISO9660
+	};
+
+	CDiskImageFS();
+	~CDiskImageFS();
+
+	bool Open(LPCWSTR imagePath);
+	void Close();
+
+	FSType GetType() const { return m_type; }
+
+	bool FindEntry(LPCWSTR innerPath, Entry& entry);
+	bool ReadDirectory(LPCWSTR innerPath, std::vector<Entry>& entries);
+
+	// positional read from the image, thread safe
+	bool ReadImage(ULONGLONG offset, void* buffer, DWORD length);
+
+	// image path helpers
+
+	// splits "image.iso\inner\path" into the image file path and the inner path
+	static bool SplitPath(LPCWSTR path, CStringW& imagePath, CStringW& innerPath);
+	static bool IsImagePath(LPCWSTR path);
+
+	// returns an opened file system for the image, shared between all readers of the same image
+	static std::shared_ptr<CDiskImageFS> GetImage(LPCWSTR imagePath);
+
+	static bool GetEntry(LPCWSTR path, Entry& entry);
+	static bool FileExists(LPCWSTR path);
+	static bool DirectoryExists(LPCWSTR path);
+	static bool ListDirectory(LPCWSTR path, std::vector<Entry>& entries);
+	static bool ReadWholeFile(LPCWSTR path, std::vector<BYTE>& data, size_t maxSize);
+
+private:
+	HANDLE     m_hImage = INVALID_HANDLE_VALUE;
+	ULONGLONG  m_imageSize = 0;
+	FSType     m_type = FS_NONE;
+
+	// UDF
+	struct Partition {
+		WORD                number = 0;
+		DWORD               start  = 0; // physical partition start in blocks
+		bool                bMetadata = false;
+		std::vector<Extent> metadataExtents; // metadata file of the UDF 2.50+ metadata partition
+	};
+	DWORD                  m_blockSize = 2048;
+	std::vector<Partition> m_partitions; // indexed by the partition reference number
+	Entry                  m_root;
+
+	// directory contents by upper-case inner path
+	std::mutex                                    m_mutexDirs;
+	std::map<CStringW, std::vector<Entry>>        m_dirs;
+
+	bool OpenUDF();
+	bool OpenISO9660();
+
+	bool ReadBlocks(ULONGLONG offset, std::vector<BYTE>& data, DWORD length);
+	bool ReadEntryData(const Entry& entry, std::vector<BYTE>& data);
+
+	bool UDFMapBlock(WORD partRef, DWORD block, ULONGLONG& offset);
+	bool UDFMapExtent(WORD partRef, DWORD block, ULONGLONG length, std::vector<Extent>& extents);
+	bool UDFReadFileEntry(WORD partRef, DWORD block, Entry& entry, int depth = 0);
+	bool UDFParseAllocation(const BYTE* ad, DWORD len, int adType, WORD partRef, std::vector<Extent>& extents, int depth);
+	bool UDFReadDirectory(const Entry& dir, std::vector<Entry>& entries);
+
+	// ISO9660
+	bool m_bJoliet = false;
+
+	bool ISOReadDirectory(const Entry& dir, std::vector<Entry>& entries);
+
+	bool GetDirectory(const CStringW& innerPath, std::vector<Entry>& entries);
+};
+
+//
+// Sequential stream over a file inside a disc image with aligned read-ahead.
+//
+
+class CDiskImageFile
+{
+public:
+	CDiskImageFile();
+	~CDiskImageFile();
+
+	bool Open(LPCWSTR path);
+	void Close();
+	bool IsOpen() const { return m_pImage != nullptr; }
+
+	ULONGLONG GetLength() const { return m_entry.size; }
+	ULONGLONG GetPosition() const { return m_pos; }
+	ULONGLONG Seek(LONGLONG offset, DWORD moveMethod);
+	DWORD Read(void* buffer, DWORD length);
+
+private:
+	std::shared_ptr<CDiskImageFS> m_pImage;
+	CDiskImageFS::Entry           m_entry;
+	ULONGLONG                     m_pos = 0;
+
+	// read-ahead buffer, covers [m_cacheStart, m_cacheStart + m_cacheSize) of the file
+	std::vector<BYTE> m_cache;
+	ULONGLONG         m_cacheStart = 0;
+	DWORD             m_cacheSize  = 0;
+
+	bool ReadAt(ULONGLONG pos, BYTE* buffer, DWORD length);
+	bool FillCache(ULONGLONG pos);
+};
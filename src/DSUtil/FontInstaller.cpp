@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2018 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -20,8 +20,21 @@
  */
 
 #include "stdafx.h"
+#include <atomic>
 #include "FontInstaller.h"
 
+static std::atomic<UINT> s_fontsVersion = 0;
+
+UINT CFontInstaller::GetFontsVersion()
+{
+	return s_fontsVersion;
+}
+
+void CFontInstaller::FontsChanged()
+{
+	s_fontsVersion++;
+}
+
 CFontInstaller::CFontInstaller()
 {
 }
@@ -33,6 +46,10 @@ CFontInstaller::~CFontInstaller()
 
 void CFontInstaller::UninstallFonts()
 {
+	if (m_fonts.empty() && m_files.empty() && m_tempfiles.empty()) {
+		return;
+	}
+
 	for (const auto& font : m_fonts) {
 		RemoveFontMemResourceEx(font);
 	}
@@ -51,6 +68,8 @@ void CFontInstaller::UninstallFonts()
 		}
 	}
 	m_tempfiles.clear();
+
+	FontsChanged();
 }
 
 bool CFontInstaller::InstallFontMemory(const void* pData, UINT len)
@@ -59,6 +78,7 @@ bool CFontInstaller::InstallFontMemory(const void* pData, UINT len)
 	HANDLE hFont = AddFontMemResourceEx((PVOID)pData, len, nullptr, &nFonts);
 	if (hFont && nFonts > 0) {
 		m_fonts.push_back(hFont);
+		FontsChanged();
 	}
 	return hFont && nFonts > 0;
 }
@@ -67,6 +87,7 @@ bool CFontInstaller::InstallFontFile(LPCWSTR filename)
 {
 	if (AddFontResourceExW(filename, FR_PRIVATE, 0) > 0) {
 		m_files.push_back(filename);
+		FontsChanged();
 		return true;
 	}
 
@@ -87,6 +108,7 @@ bool CFontInstaller::InstallFontTempFile(const void* pData, UINT len)
 
 		if (AddFontResourceExW(fn, FR_PRIVATE, 0) > 0) {
 			m_tempfiles.push_back(fn);
+			FontsChanged();
 			return true;
 		}
 	}
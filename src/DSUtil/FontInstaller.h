@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -36,4 +36,9 @@ public:
 	bool InstallFontTempFile(const void* pData, UINT len);
 
 	void UninstallFonts();
+
+	// changes whenever fonts are installed or removed in this process,
+	// cached font data of an older version may belong to another font of the same name
+	static UINT GetFontsVersion();
+	static void FontsChanged();
 };
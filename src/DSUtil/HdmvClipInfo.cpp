@@ -1,5 +1,5 @@
 /*
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -23,11 +23,107 @@
 #include "DSUtil.h"
 #include "GolombBuffer.h"
 #include "FileHandle.h"
+#include "DiskImageFS.h"
 #include <sys\stat.h>
 #include <regex>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
 
 extern LCID ISO6392ToLcid(LPCSTR code);
 
+//
+// Process-wide cache of the parsed BD metadata.
+// Entries are validated by the file size and last write time, so a changed disc or folder is reparsed.
+//
+
+namespace {
+	struct FileStamp {
+		ULONGLONG size  = 0;
+		ULONGLONG mtime = 0;
+
+		bool operator == (const FileStamp& fs) const {
+			return size == fs.size && mtime == fs.mtime;
+		}
+	};
+
+	bool GetFileStamp(LPCWSTR path, FileStamp& stamp)
+	{
+		CStringW imagePath, innerPath;
+		if (CDiskImageFS::SplitPath(path, imagePath, innerPath)) {
+			// files inside a disc image are validated by the image time stamp
+			CDiskImageFS::Entry entry;
+			if (!CDiskImageFS::GetEntry(path, entry) || !GetFileStamp(imagePath, stamp)) {
+				return false;
+			}
+			stamp.size = entry.size;
+			return true;
+		}
+
+		WIN32_FILE_ATTRIBUTE_DATA fad;
+		if (!GetFileAttributesExW(path, GetFileExInfoStandard, &fad)) {
+			return false;
+		}
+
+		stamp.size  = ((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+		stamp.mtime = ((ULONGLONG)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime;
+		return true;
+	}
+
+	struct ClipCacheEntry {
+		FileStamp                  stamp;
+		CHdmvClipInfo::Streams     streams;
+		CHdmvClipInfo::SyncPoints  sps;
+		bool                       bHasSps = false;
+	};
+
+	struct PlaylistCacheEntry {
+		FileStamp                  stamp;
+		std::vector<FileStamp>     dirs;
+		HRESULT                    hr = E_FAIL;
+		REFERENCE_TIME             rtDuration = 0;
+		CHdmvClipInfo::CPlaylist   playlist;
+	};
+
+	struct MainMovieCacheEntry {
+		std::vector<std::pair<CStringW, FileStamp>> files;
+		std::vector<FileStamp>     dirs;
+		HRESULT                    hr = E_FAIL;
+		CStringW                   strPlaylistFile;
+		CHdmvClipInfo::CPlaylist   playlists;
+	};
+
+	// the playlists skip the missing clips, and adding or removing a clip
+	// changes the last write time of the STREAM or CLIPINF directory
+	std::vector<FileStamp> GetClipDirsStamps(const CStringW& bdmvPath)
+	{
+		std::vector<FileStamp> stamps(2);
+		GetFileStamp(bdmvPath + L"\\STREAM", stamps[0]);
+		GetFileStamp(bdmvPath + L"\\CLIPINF", stamps[1]);
+		return stamps;
+	}
+
+	bool FileExists(LPCWSTR path)
+	{
+		return CDiskImageFS::IsImagePath(path) ? CDiskImageFS::FileExists(path) : !!::PathFileExistsW(path);
+	}
+
+	constexpr size_t MAX_CACHED_CLIPS     = 4096;
+	constexpr size_t MAX_CACHED_PLAYLISTS = 4096;
+	constexpr size_t MAX_CACHED_DISCS     = 16;
+
+	std::mutex                                   s_cacheMutex;
+	std::map<CStringW, ClipCacheEntry>           s_clipCache;
+	std::map<CStringW, PlaylistCacheEntry>       s_playlistCache;
+	std::map<CStringW, MainMovieCacheEntry>      s_mainMovieCache;
+
+	inline CStringW CacheKey(LPCWSTR path)
+	{
+		return CStringW(path).MakeUpper();
+	}
+}
+
 CHdmvClipInfo::CHdmvClipInfo() = default;
 
 CHdmvClipInfo::~CHdmvClipInfo()
@@ -35,20 +131,61 @@ CHdmvClipInfo::~CHdmvClipInfo()
 	CloseFile(S_OK);
 }
 
-HRESULT CHdmvClipInfo::CloseFile(HRESULT hr)
+#define dwShareMode          FILE_SHARE_READ | FILE_SHARE_WRITE
+#define dwFlagsAndAttributes FILE_ATTRIBUTE_READONLY | FILE_FLAG_SEQUENTIAL_SCAN
+
+HRESULT CHdmvClipInfo::OpenFile(LPCWSTR strFile)
 {
-	if (m_hFile != INVALID_HANDLE_VALUE) {
-		CloseHandle(m_hFile);
-		m_hFile = INVALID_HANDLE_VALUE;
+	CloseFile(S_OK);
+
+	if (CDiskImageFS::IsImagePath(strFile)) {
+		return CDiskImageFS::ReadWholeFile(strFile, m_Buffer, 64 * MEGABYTE) && m_Buffer.size() >= 8 ? S_OK : VFW_E_INVALID_FILE_FORMAT;
+	}
+
+	HANDLE hFile = CreateFileW(strFile, GENERIC_READ, dwShareMode, nullptr,
+							   OPEN_EXISTING, dwFlagsAndAttributes, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return AmHresultFromWin32(GetLastError());
 	}
 
+	HRESULT hr = S_OK;
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart < 8 || size.QuadPart > 64 * MEGABYTE) {
+		hr = VFW_E_INVALID_FILE_FORMAT;
+	} else {
+		m_Buffer.resize((size_t)size.QuadPart);
+		DWORD dwRead = 0;
+		if (!ReadFile(hFile, m_Buffer.data(), (DWORD)m_Buffer.size(), &dwRead, nullptr) || dwRead != m_Buffer.size()) {
+			m_Buffer.clear();
+			hr = E_FAIL;
+		}
+	}
+
+	CloseHandle(hFile);
+
+	return hr;
+}
+
+HRESULT CHdmvClipInfo::CloseFile(HRESULT hr)
+{
+	m_Buffer.clear();
+	m_nPos = 0;
+
 	return hr;
 }
 
 void CHdmvClipInfo::ReadBuffer(void* pBuff, DWORD nLen)
 {
-	DWORD dwRead;
-	ReadFile(m_hFile, pBuff, nLen, &dwRead, nullptr);
+	const size_t nAvail = m_nPos < m_Buffer.size() ? m_Buffer.size() - m_nPos : 0;
+	const size_t nCopy = std::min<size_t>(nLen, nAvail);
+	if (nCopy) {
+		memcpy(pBuff, m_Buffer.data() + m_nPos, nCopy);
+	}
+	if (nCopy < nLen) {
+		memset((BYTE*)pBuff + nCopy, 0, nLen - nCopy);
+	}
+
+	m_nPos += nLen;
 }
 
 DWORD CHdmvClipInfo::ReadDword()
@@ -77,24 +214,31 @@ BYTE CHdmvClipInfo::ReadByte()
 
 BOOL CHdmvClipInfo::Skip(LONGLONG nLen)
 {
-	LARGE_INTEGER newPos = {};
-	newPos.QuadPart = nLen;
-	return SetFilePointerEx(m_hFile, newPos, nullptr, FILE_CURRENT);
+	return SetPos(nLen, FILE_CURRENT);
 }
 
 BOOL CHdmvClipInfo::GetPos(LONGLONG& Pos)
 {
-	LARGE_INTEGER curPos = {};
-	const BOOL bRet = SetFilePointerEx(m_hFile, curPos, &curPos, FILE_CURRENT);
-	Pos = curPos.QuadPart;
+	Pos = (LONGLONG)m_nPos;
 
-	return bRet;
+	return TRUE;
 }
+
 BOOL CHdmvClipInfo::SetPos(LONGLONG Pos, DWORD dwMoveMethod/* = FILE_BEGIN*/)
 {
-	LARGE_INTEGER newPos = {};
-	newPos.QuadPart = Pos;
-	return SetFilePointerEx(m_hFile, newPos, nullptr, dwMoveMethod);
+	if (dwMoveMethod == FILE_CURRENT) {
+		Pos += (LONGLONG)m_nPos;
+	} else if (dwMoveMethod == FILE_END) {
+		Pos += (LONGLONG)m_Buffer.size();
+	}
+
+	if (Pos < 0) {
+		return FALSE;
+	}
+
+	m_nPos = (size_t)Pos;
+
+	return TRUE;
 }
 
 HRESULT CHdmvClipInfo::ReadLang(Stream& s)
@@ -305,16 +449,74 @@ HRESULT CHdmvClipInfo::ReadCpiInfo(SyncPoints& sps)
 	return S_OK;
 }
 
-#define dwShareMode          FILE_SHARE_READ | FILE_SHARE_WRITE
-#define dwFlagsAndAttributes FILE_ATTRIBUTE_READONLY | FILE_FLAG_SEQUENTIAL_SCAN
-
 #define CheckVer() (!(memcmp(Buff, "0300", 4)) || (!memcmp(Buff, "0200", 4)) || (!memcmp(Buff, "0100", 4)))
 
 HRESULT CHdmvClipInfo::ReadInfo(LPCWSTR strFile, SyncPoints* sps/* = nullprt*/)
 {
-	m_hFile = CreateFileW(strFile, GENERIC_READ, dwShareMode, nullptr,
-						  OPEN_EXISTING, dwFlagsAndAttributes, nullptr);
-	if (m_hFile != INVALID_HANDLE_VALUE) {
+	const CStringW key = CacheKey(strFile);
+	FileStamp stamp;
+	const bool bStamp = GetFileStamp(strFile, stamp);
+
+	Streams streams;
+	if (bStamp) {
+		std::unique_lock<std::mutex> lock(s_cacheMutex);
+		const auto it = s_clipCache.find(key);
+		if (it != s_clipCache.end() && it->second.stamp == stamp && (!sps || it->second.bHasSps)) {
+			streams = it->second.streams;
+			if (sps) {
+				*sps = it->second.sps;
+			}
+			lock.unlock();
+
+			MergeStreams(streams);
+			return S_OK;
+		}
+	}
+
+	// parse into an empty list to get the streams of this clip only, then merge them like ReadProgramInfo() does
+	std::swap(streams, m_Streams);
+	const HRESULT hr = ReadClipInfo(strFile, sps);
+	std::swap(streams, m_Streams);
+
+	if (hr == S_OK) {
+		MergeStreams(streams);
+
+		if (bStamp) {
+			std::unique_lock<std::mutex> lock(s_cacheMutex);
+			if (s_clipCache.size() >= MAX_CACHED_CLIPS) {
+				s_clipCache.clear();
+			}
+			auto& entry   = s_clipCache[key];
+			entry.stamp   = stamp;
+			entry.streams = std::move(streams);
+			entry.bHasSps = sps != nullptr;
+			if (sps) {
+				entry.sps = *sps;
+			} else {
+				entry.sps.clear();
+			}
+		}
+	}
+
+	return hr;
+}
+
+void CHdmvClipInfo::MergeStreams(const Streams& streams)
+{
+	for (const auto& s : streams) {
+		const auto it = std::find_if(m_Streams.cbegin(), m_Streams.cend(), [&s](const Stream& stream) {
+			return stream.m_PID == s.m_PID;
+		});
+		if (it == m_Streams.cend()) {
+			m_Streams.emplace_back(s);
+		}
+	}
+}
+
+HRESULT CHdmvClipInfo::ReadClipInfo(LPCWSTR strFile, SyncPoints* sps)
+{
+	HRESULT hr = OpenFile(strFile);
+	if (SUCCEEDED(hr)) {
 		BYTE Buff[4] = { 0 };
 
 		ReadBuffer(Buff, 4);
@@ -364,7 +566,7 @@ HRESULT CHdmvClipInfo::ReadInfo(LPCWSTR strFile, SyncPoints* sps/* = nullprt*/)
 		return CloseFile(S_OK);
 	}
 
-	return AmHresultFromWin32(GetLastError());
+	return hr;
 }
 
 const CHdmvClipInfo::Stream* CHdmvClipInfo::FindStream(SHORT wPID)
@@ -550,9 +752,8 @@ HRESULT CHdmvClipInfo::ReadPlaylist(const CString& strPlaylistFile, REFERENCE_TI
 	m_Streams.clear();
 	stn.m_Streams.clear();
 
-	m_hFile = CreateFileW(strPlaylistFile, GENERIC_READ, dwShareMode, nullptr,
-						  OPEN_EXISTING, dwFlagsAndAttributes, nullptr);
-	if (m_hFile != INVALID_HANDLE_VALUE) {
+	HRESULT hr = OpenFile(strPlaylistFile);
+	if (SUCCEEDED(hr)) {
 		bool bDuplicate = false;
 		BYTE Buff[9] = { 0 };
 
@@ -566,9 +767,7 @@ HRESULT CHdmvClipInfo::ReadPlaylist(const CString& strPlaylistFile, REFERENCE_TI
 			return CloseFile(VFW_E_INVALID_FILE_FORMAT);
 		}
 
-		LARGE_INTEGER size = {};
-		GetFileSizeEx(m_hFile, &size);
-		Playlist.m_mpls_size = size.QuadPart;
+		Playlist.m_mpls_size = m_Buffer.size();
 
 		DLog(L"CHdmvClipInfo::ReadPlaylist() : '%s'", strPlaylistFile);
 
@@ -700,7 +899,7 @@ HRESULT CHdmvClipInfo::ReadPlaylist(const CString& strPlaylistFile, REFERENCE_TI
 
 			PlaylistItem Item;
 			Item.m_strFileName.Format(format, Path, (char*)&Buff[0]);
-			if (!::PathFileExistsW(Item.m_strFileName)) {
+			if (!FileExists(Item.m_strFileName)) {
 				DLog(L"    ==> '%s' is missing, skip it", Item.m_strFileName);
 
 				stnssextPos = 0;
@@ -744,12 +943,17 @@ HRESULT CHdmvClipInfo::ReadPlaylist(const CString& strPlaylistFile, REFERENCE_TI
 			Item.m_ig_offset_sequence_id.resize(stn.num_ig, 0xFF);
 
 			if (bFullInfoRead) {
-				size = {};
-				HANDLE hFile = CreateFileW(Item.m_strFileName, GENERIC_READ, dwShareMode, nullptr,
-										   OPEN_EXISTING, dwFlagsAndAttributes, nullptr);
-				if (hFile != INVALID_HANDLE_VALUE) {
-					GetFileSizeEx(hFile, &size);
-					CloseHandle(hFile);
+				LARGE_INTEGER size = {};
+				CDiskImageFS::Entry entry;
+				if (CDiskImageFS::GetEntry(Item.m_strFileName, entry)) {
+					size.QuadPart = entry.size;
+				} else {
+					HANDLE hFile = CreateFileW(Item.m_strFileName, GENERIC_READ, dwShareMode, nullptr,
+											   OPEN_EXISTING, dwFlagsAndAttributes, nullptr);
+					if (hFile != INVALID_HANDLE_VALUE) {
+						GetFileSizeEx(hFile, &size);
+						CloseHandle(hFile);
+					}
 				}
 
 				Item.m_SizeIn  = TotalSize;
@@ -937,16 +1141,15 @@ HRESULT CHdmvClipInfo::ReadPlaylist(const CString& strPlaylistFile, REFERENCE_TI
 		return Playlist.empty() ? E_FAIL : bDuplicate ? S_FALSE : S_OK;
 	}
 
-	return AmHresultFromWin32(GetLastError());
+	return hr;
 }
 
 HRESULT CHdmvClipInfo::ReadChapters(const CString& strPlaylistFile, const CPlaylist& PlaylistItems, CPlaylistChapter& Chapters)
 {
 	Chapters.clear();
 
-	m_hFile = CreateFileW(strPlaylistFile, GENERIC_READ, dwShareMode, nullptr,
-						  OPEN_EXISTING, dwFlagsAndAttributes, nullptr);
-	if (m_hFile != INVALID_HANDLE_VALUE) {
+	HRESULT hr = OpenFile(strPlaylistFile);
+	if (SUCCEEDED(hr)) {
 		BYTE Buff[4] = { 0 };
 
 		ReadBuffer(Buff, 4);
@@ -1044,7 +1247,45 @@ HRESULT CHdmvClipInfo::ReadChapters(const CString& strPlaylistFile, const CPlayl
 		return CloseFile(S_OK);
 	}
 
-	return AmHresultFromWin32(GetLastError());
+	return hr;
+}
+
+HRESULT CHdmvClipInfo::ReadPlaylistCached(const CString& strPlaylistFile, REFERENCE_TIME& rtDuration, CPlaylist& Playlist)
+{
+	const CStringW key = CacheKey(strPlaylistFile);
+	FileStamp stamp;
+	const bool bStamp = GetFileStamp(strPlaylistFile, stamp);
+
+	CStringW bdmvPath = GetFolderPath(strPlaylistFile);
+	RemoveFileSpec(bdmvPath);
+	std::vector<FileStamp> dirs = GetClipDirsStamps(bdmvPath);
+
+	if (bStamp) {
+		std::unique_lock<std::mutex> lock(s_cacheMutex);
+		const auto it = s_playlistCache.find(key);
+		if (it != s_playlistCache.end() && it->second.stamp == stamp && it->second.dirs == dirs) {
+			rtDuration = it->second.rtDuration;
+			Playlist   = it->second.playlist;
+			return it->second.hr;
+		}
+	}
+
+	const HRESULT hr = ReadPlaylist(strPlaylistFile, rtDuration, Playlist);
+
+	if (bStamp) {
+		std::unique_lock<std::mutex> lock(s_cacheMutex);
+		if (s_playlistCache.size() >= MAX_CACHED_PLAYLISTS) {
+			s_playlistCache.clear();
+		}
+		auto& entry      = s_playlistCache[key];
+		entry.stamp      = stamp;
+		entry.dirs       = std::move(dirs);
+		entry.hr         = hr;
+		entry.rtDuration = rtDuration;
+		entry.playlist   = Playlist;
+	}
+
+	return hr;
 }
 
 HRESULT CHdmvClipInfo::FindMainMovie(LPCWSTR strFolder, CString& strPlaylistFile, CPlaylist& Playlists)
@@ -1054,74 +1295,155 @@ HRESULT CHdmvClipInfo::FindMainMovie(LPCWSTR strFolder, CString& strPlaylistFile
 
 	Playlists.clear();
 
+	std::vector<std::pair<CStringW, FileStamp>> files;
+
+	std::vector<CDiskImageFS::Entry> entries;
+	if (CDiskImageFS::ListDirectory(strPath + L"\\PLAYLIST", entries)) {
+		FileStamp imageStamp;
+		GetFileStamp(strPath + L"\\PLAYLIST", imageStamp);
+		for (const auto& entry : entries) {
+			if (!entry.bDirectory && GetFileExt(entry.name).MakeLower() == L".mpls") {
+				FileStamp stamp;
+				stamp.size  = entry.size;
+				stamp.mtime = imageStamp.mtime;
+				files.emplace_back(strPath + L"\\PLAYLIST\\" + entry.name, stamp);
+			}
+		}
+	}
+
 	WIN32_FIND_DATA fd = {0};
 	HANDLE hFind = FindFirstFileW(strPath + L"\\PLAYLIST\\*.mpls", &fd);
 	if (hFind != INVALID_HANDLE_VALUE) {
-		std::vector<CPlaylist> PlaylistArray;
-		REFERENCE_TIME rtMax = 0;
-		REFERENCE_TIME rtCurrent;
-		CString        strCurrentPlaylist;
-		__int64        mpls_size_max = 0;
-		unsigned       max_video_res = 0;
 		do {
-			CPlaylist Playlist;
-			strCurrentPlaylist = strPath + L"\\PLAYLIST\\" + fd.cFileName;
-			// Main movie shouldn't have duplicate M2TS filename ...
-			if (ReadPlaylist(strCurrentPlaylist, rtCurrent, Playlist) == S_OK) {
-				if ((rtCurrent > rtMax && Playlist.m_max_video_res >= max_video_res)
-						|| (rtCurrent == rtMax && Playlist.m_mpls_size > mpls_size_max)
-						|| ((rtCurrent < rtMax && rtCurrent >= rtMax / 2) && Playlist.m_max_video_res > max_video_res)) {
-					rtMax           = rtCurrent;
-					mpls_size_max   = Playlist.m_mpls_size;
-					max_video_res   = Playlist.m_max_video_res;
-					strPlaylistFile = strCurrentPlaylist;
-					hr = S_OK;
-				}
+			FileStamp stamp;
+			stamp.size  = ((ULONGLONG)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+			stamp.mtime = ((ULONGLONG)fd.ftLastWriteTime.dwHighDateTime << 32) | fd.ftLastWriteTime.dwLowDateTime;
+			files.emplace_back(strPath + L"\\PLAYLIST\\" + fd.cFileName, stamp);
+		} while (FindNextFileW(hFind, &fd));
 
-				if (rtCurrent >= 2 * UNITS) { // 2 seconds
-					// Search duplicate playlists ...
-					bool duplicate = false;
-					if (!Playlists.empty()) {
-						for (const auto& item : PlaylistArray) {
-							if (item.size() != Playlist.size()) {
-								continue;
-							}
+		FindClose(hFind);
+	}
 
-							duplicate = true;
-							for (size_t i = 0; i < item.size() && duplicate; i++) {
-								if (item[i] == Playlist[i]) {
-									continue;
-								}
+	if (files.empty()) {
+		return hr;
+	}
 
-								duplicate = false;
-							}
+	std::vector<FileStamp> dirs = GetClipDirsStamps(strPath);
+
+	// the same disc (or folder) was already scanned and nothing has changed
+	const CStringW discKey = CacheKey(strPath);
+	{
+		std::unique_lock<std::mutex> lock(s_cacheMutex);
+		const auto it = s_mainMovieCache.find(discKey);
+		if (it != s_mainMovieCache.end() && it->second.files == files && it->second.dirs == dirs) {
+			strPlaylistFile = it->second.strPlaylistFile;
+			Playlists       = it->second.playlists;
+			return it->second.hr;
+		}
+	}
+
+	struct PlaylistInfo {
+		HRESULT        hr = E_FAIL;
+		REFERENCE_TIME rtDuration = 0;
+		CPlaylist      Playlist;
+	};
+	std::vector<PlaylistInfo> infos(files.size());
+
+	// discs with a lot of obfuscation playlists are parsed in parallel, the selection below stays sequential
+	std::atomic<size_t> nextIndex = 0;
+	auto worker = [&files, &infos, &nextIndex]() {
+		CHdmvClipInfo ClipInfo;
+		for (size_t i = nextIndex++; i < files.size(); i = nextIndex++) {
+			auto& info = infos[i];
+			info.hr = ClipInfo.ReadPlaylistCached(files[i].first, info.rtDuration, info.Playlist);
+		}
+	};
+
+	const size_t nThreads = std::min<size_t>({ std::max(std::thread::hardware_concurrency(), 1u), 8, (files.size() + 15) / 16 });
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < nThreads; i++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	std::vector<CPlaylist> PlaylistArray;
+	REFERENCE_TIME rtMax = 0;
+	__int64        mpls_size_max = 0;
+	unsigned       max_video_res = 0;
+	for (size_t n = 0; n < files.size(); n++) {
+		const CString& strCurrentPlaylist = files[n].first;
+		const REFERENCE_TIME rtCurrent = infos[n].rtDuration;
+		const CPlaylist& Playlist = infos[n].Playlist;
+
+		// Main movie shouldn't have duplicate M2TS filename ...
+		if (infos[n].hr == S_OK) {
+			if ((rtCurrent > rtMax && Playlist.m_max_video_res >= max_video_res)
+					|| (rtCurrent == rtMax && Playlist.m_mpls_size > mpls_size_max)
+					|| ((rtCurrent < rtMax && rtCurrent >= rtMax / 2) && Playlist.m_max_video_res > max_video_res)) {
+				rtMax           = rtCurrent;
+				mpls_size_max   = Playlist.m_mpls_size;
+				max_video_res   = Playlist.m_max_video_res;
+				strPlaylistFile = strCurrentPlaylist;
+				hr = S_OK;
+			}
 
-							if (duplicate) {
-								duplicate = (item.m_mpls_size == Playlist.m_mpls_size);
+			if (rtCurrent >= 2 * UNITS) { // 2 seconds
+				// Search duplicate playlists ...
+				bool duplicate = false;
+				if (!Playlists.empty()) {
+					for (const auto& item : PlaylistArray) {
+						if (item.size() != Playlist.size()) {
+							continue;
+						}
+
+						duplicate = true;
+						for (size_t i = 0; i < item.size() && duplicate; i++) {
+							if (item[i] == Playlist[i]) {
+								continue;
 							}
+
+							duplicate = false;
+						}
+
+						if (duplicate) {
+							duplicate = (item.m_mpls_size == Playlist.m_mpls_size);
 						}
 					}
-					if (duplicate) {
-						continue;
-					}
+				}
+				if (duplicate) {
+					continue;
+				}
 
-					PlaylistItem Item;
-					Item.m_strFileName = strCurrentPlaylist;
-					Item.m_rtOut       = rtCurrent;
-					Item.m_SizeOut     = Playlist.m_mpls_size;
-					Playlists.emplace_back(Item);
+				PlaylistItem Item;
+				Item.m_strFileName = strCurrentPlaylist;
+				Item.m_rtOut       = rtCurrent;
+				Item.m_SizeOut     = Playlist.m_mpls_size;
+				Playlists.emplace_back(Item);
 
-					PlaylistArray.emplace_back(Playlist);
-				}
+				PlaylistArray.emplace_back(Playlist);
 			}
-		} while (FindNextFileW(hFind, &fd));
-
-		FindClose(hFind);
+		}
 	}
 
 	if (Playlists.size() == 1) {
 		Playlists.clear();
 	}
 
+	{
+		std::unique_lock<std::mutex> lock(s_cacheMutex);
+		if (s_mainMovieCache.size() >= MAX_CACHED_DISCS) {
+			s_mainMovieCache.clear();
+		}
+		auto& entry           = s_mainMovieCache[discKey];
+		entry.files           = std::move(files);
+		entry.dirs            = std::move(dirs);
+		entry.hr              = hr;
+		entry.strPlaylistFile = hr == S_OK ? strPlaylistFile : CString();
+		entry.playlists       = Playlists;
+	}
+
 	return hr;
 }
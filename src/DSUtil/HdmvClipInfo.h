@@ -166,7 +166,9 @@ private :
 	DWORD  Cpi_start_addrress        = 0;
 	DWORD  Ext_data_start_address    = 0;
 
-	HANDLE m_hFile = INVALID_HANDLE_VALUE;
+	// the whole MPLS/CLPI file is read into memory once, all parsing is done from the buffer
+	std::vector<BYTE> m_Buffer;
+	size_t            m_nPos = 0;
 
 	Streams m_Streams;
 
@@ -191,6 +193,12 @@ private :
 	BOOL    GetPos(LONGLONG& Pos);
 	BOOL    SetPos(LONGLONG Pos, DWORD dwMoveMethod = FILE_BEGIN);
 
+	HRESULT OpenFile(LPCWSTR strFile);
+
+	HRESULT ReadClipInfo(LPCWSTR strFile, SyncPoints* sps);
+	void    MergeStreams(const Streams& streams);
+	HRESULT ReadPlaylistCached(const CString& strPlaylistFile, REFERENCE_TIME& rtDuration, CPlaylist& Playlist);
+
 	HRESULT ReadLang(Stream& s);
 	HRESULT ReadProgramInfo();
 	HRESULT ReadCpiInfo(SyncPoints& sps);
@@ -23,6 +23,71 @@
 #include <mpc_defines.h>
 #include "DSUtil/Utils.h"
 #include "MemSubPic.h"
+#include <emmintrin.h>
+
+// blends a row of premultiplied source pixels, the alpha is the transparency of the source
+static void AlphaBltRow(const BYTE* s, uint32_t* d, int w)
+{
+	const __m128i zero   = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(0xff);
+	const __m128i maskB  = _mm_set1_epi64x(0x00000000000000ff);
+	const __m128i maskGR = _mm_set1_epi64x(0x000000ff00ff0000);
+#ifdef _WIN64
+	const __m128i w256   = _mm_set1_epi16(256);
+#endif
+
+	int x = 0;
+	for (; x + 4 <= w; x += 4, s += 16, d += 4) {
+		const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+		__m128i a = _mm_srli_epi32(src, 24);
+		const __m128i skip = _mm_cmpeq_epi32(a, opaque);
+		if (_mm_movemask_epi8(skip) == 0xffff) {
+			continue;
+		}
+
+		const __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+
+		a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+		__m128i res[2];
+		for (int i = 0; i < 2; i++) {
+			const __m128i a16 = i ? _mm_unpackhi_epi32(a, a) : _mm_unpacklo_epi32(a, a);
+			const __m128i s16 = i ? _mm_unpackhi_epi8(src, zero) : _mm_unpacklo_epi8(src, zero);
+			const __m128i d16 = i ? _mm_unpackhi_epi8(dst, zero) : _mm_unpacklo_epi8(dst, zero);
+
+			const __m128i p = _mm_mullo_epi16(d16, a16);
+#ifdef _WIN64
+			const __m128i q = _mm_mullo_epi16(s16, _mm_sub_epi16(w256, a16));
+			const __m128i t = _mm_add_epi16(_mm_srli_epi16(p, 8), _mm_srli_epi16(q, 8));
+			const __m128i f = _mm_add_epi16(p, q);
+#else
+			const __m128i t = _mm_add_epi16(_mm_srli_epi16(p, 8), s16);
+			const __m128i f = _mm_add_epi16(p, _mm_slli_epi16(s16, 8));
+#endif
+			// blue and red are blended as one 32-bit value below, the blue overflow carries into red
+			const __m128i carry = _mm_slli_epi64(_mm_and_si128(_mm_srli_epi16(t, 8), maskB), 32);
+			const __m128i r = _mm_srli_epi16(_mm_add_epi16(f, carry), 8);
+			res[i] = _mm_or_si128(_mm_and_si128(t, maskB), _mm_and_si128(r, maskGR));
+		}
+
+		const __m128i out = _mm_packus_epi16(res[0], res[1]);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_or_si128(_mm_and_si128(skip, dst), _mm_andnot_si128(skip, out)));
+	}
+
+	for (; x < w; x++, s += 4, d++) {
+#ifdef _WIN64
+		uint32_t ia = 256-s[3];
+		if (s[3] < 0xff) {
+			*d = ((((*d&0x00ff00ff)*s[3])>>8) + (((*((uint32_t*)s)&0x00ff00ff)*ia)>>8)&0x00ff00ff)
+				| ((((*d&0x0000ff00)*s[3])>>8) + (((*((uint32_t*)s)&0x0000ff00)*ia)>>8)&0x0000ff00);
+		}
+#else
+		if (s[3] < 0xff) {
+			*d = ((((*d&0x00ff00ff)*s[3])>>8) + (*((uint32_t*)s)&0x00ff00ff)&0x00ff00ff)
+				| ((((*d&0x0000ff00)*s[3])>>8) + (*((uint32_t*)s)&0x0000ff00)&0x0000ff00);
+		}
+#endif
+	}
+}
 
 //
 // CMemSubPic
@@ -166,24 +231,7 @@ STDMETHODIMP CMemSubPic::AlphaBlt(RECT* pSrc, RECT* pDst, SubPicDesc* pTarget)
 	}
 
 	for (int j = 0; j < h; j++, s += src.pitch, d += dst.pitch) {
-		BYTE* s2 = s;
-		BYTE* s2end = s2 + w * 4;
-
-		uint32_t* d2 = (uint32_t*)d;
-		for (; s2 < s2end; s2 += 4, d2++) {
-#ifdef _WIN64
-			uint32_t ia = 256-s2[3];
-			if (s2[3] < 0xff) {
-				*d2 = ((((*d2&0x00ff00ff)*s2[3])>>8) + (((*((uint32_t*)s2)&0x00ff00ff)*ia)>>8)&0x00ff00ff)
-					| ((((*d2&0x0000ff00)*s2[3])>>8) + (((*((uint32_t*)s2)&0x0000ff00)*ia)>>8)&0x0000ff00);
-			}
-#else
-			if (s2[3] < 0xff) {
-				*d2 = ((((*d2&0x00ff00ff)*s2[3])>>8) + (*((uint32_t*)s2)&0x00ff00ff)&0x00ff00ff)
-					| ((((*d2&0x0000ff00)*s2[3])>>8) + (*((uint32_t*)s2)&0x0000ff00)&0x0000ff00);
-			}
-#endif
-		}
+		AlphaBltRow(s, (uint32_t*)d, w);
 	}
 
 	dst.pitch = abs(dst.pitch);
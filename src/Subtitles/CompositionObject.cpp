@@ -1,5 +1,5 @@
 /*
- * (C) 2006-2022 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -22,6 +22,7 @@
 #include "CompositionObject.h"
 #include "ColorConvert.h"
 #include "DSUtil/GolombBuffer.h"
+#include <emmintrin.h>
 #include <d3d9types.h>
 
 CompositionObject::CompositionObject()
@@ -38,10 +39,15 @@ void CompositionObject::SetPalette(int nNbEntry, HDMV_PALETTE* pPalette, bool bR
 {
 	m_nColorNumber = nNbEntry;
 	for (int i = 0; i < nNbEntry; i++) {
+		DWORD color;
 		if (bIsRGB) {
-			m_Colors[pPalette[i].entry_id] = D3DCOLOR_ARGB(pPalette[i].T, pPalette[i].Y, pPalette[i].Cr, pPalette[i].Cb);
+			color = D3DCOLOR_ARGB(pPalette[i].T, pPalette[i].Y, pPalette[i].Cr, pPalette[i].Cb);
 		} else {
-			m_Colors[pPalette[i].entry_id] = ColorConvert::YCrCbToRGB(pPalette[i].T, pPalette[i].Y, pPalette[i].Cr, pPalette[i].Cb, bRec709, type);
+			color = ColorConvert::YCrCbToRGB(pPalette[i].T, pPalette[i].Y, pPalette[i].Cr, pPalette[i].Cb, bRec709, type);
+		}
+		if (m_Colors[pPalette[i].entry_id] != color) {
+			m_Colors[pPalette[i].entry_id] = color;
+			m_Bitmap.clear();
 		}
 	}
 }
@@ -49,6 +55,7 @@ void CompositionObject::SetPalette(int nNbEntry, HDMV_PALETTE* pPalette, bool bR
 void CompositionObject::SetRLEData(const BYTE* pBuffer, int nSize, int nTotalSize)
 {
 	SAFE_DELETE_ARRAY(m_pRLEData);
+	m_Bitmap.clear();
 
 	m_pRLEData		= DNew BYTE[nTotalSize];
 	m_nRLEDataSize	= nTotalSize;
@@ -63,6 +70,88 @@ void CompositionObject::AppendRLEData(const BYTE* pBuffer, int nSize)
 	if (m_nRLEPos + nSize <= m_nRLEDataSize) {
 		memcpy(m_pRLEData + m_nRLEPos, pBuffer, nSize);
 		m_nRLEPos += nSize;
+		m_Bitmap.clear();
+	}
+}
+
+void CompositionObject::InitBitmap()
+{
+	m_nBitmapWidth  = m_width;
+	m_nBitmapHeight = m_height;
+	m_Bitmap.assign((size_t)m_width * m_height, 0);
+}
+
+void CompositionObject::FillBitmap(int nX, int nY, int nCount, DWORD color)
+{
+	if (nX < 0 || nY < 0 || nY >= m_nBitmapHeight) {
+		return;
+	}
+
+	nCount = std::min(nCount, m_nBitmapWidth - nX);
+	if (nCount > 0) {
+		fill_u32(&m_Bitmap[(size_t)nY * m_nBitmapWidth + nX], color, nCount);
+	}
+}
+
+// Same blending as FillSolidRect for every pixel, the alpha of the bitmap color is the opacity
+void CompositionObject::DrawBitmap(SubPicDesc& spd, int nX, int nY)
+{
+	ASSERT(nX >= 0 && nY >= 0);
+	if (nX < 0 || nY < 0) {
+		return;
+	}
+
+	const int w = std::min((int)m_nBitmapWidth, spd.w - nX);
+	const int h = std::min((int)m_nBitmapHeight, spd.h - nY);
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgb  = _mm_set1_epi32(0x00FFFFFF);
+	const __m128i w256 = _mm_set1_epi16(0x100);
+	const __m128i ones = _mm_set1_epi16(1);
+
+	for (int y = 0; y < h; y++) {
+		const DWORD* src = &m_Bitmap[(size_t)y * m_nBitmapWidth];
+		DWORD* dst = (DWORD*)(spd.bits + spd.pitch * (nY + y)) + nX;
+
+		int x = 0;
+		for (; x + 4 <= w; x += 4) {
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+			__m128i a = _mm_srli_epi32(c, 24);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xFFFF) {
+				continue;
+			}
+
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x));
+
+			a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+			__m128i a1 = _mm_unpacklo_epi32(a, a);
+			__m128i a2 = _mm_unpackhi_epi32(a, a);
+
+			c = _mm_and_si128(c, rgb);
+			__m128i c1 = _mm_unpacklo_epi8(c, zero);
+			__m128i c2 = _mm_unpackhi_epi8(c, zero);
+			__m128i d1 = _mm_unpacklo_epi8(d, zero);
+			__m128i d2 = _mm_unpackhi_epi8(d, zero);
+
+			// dst * (256 - alpha) + color * (alpha + 1) fits in 16 bits
+			d1 = _mm_add_epi16(_mm_mullo_epi16(d1, _mm_sub_epi16(w256, a1)), _mm_mullo_epi16(c1, _mm_add_epi16(a1, ones)));
+			d2 = _mm_add_epi16(_mm_mullo_epi16(d2, _mm_sub_epi16(w256, a2)), _mm_mullo_epi16(c2, _mm_add_epi16(a2, ones)));
+			d1 = _mm_srli_epi16(d1, 8);
+			d2 = _mm_srli_epi16(d2, 8);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(d1, d2));
+		}
+		for (; x < w; x++) {
+			const DWORD a = src[x] >> 24;
+			if (a) {
+				const BYTE* c = (const BYTE*)&src[x];
+				BYTE* d = (BYTE*)&dst[x];
+				for (int i = 0; i < 3; i++) {
+					d[i] = (BYTE)((d[i] * (0x100 - a) + c[i] * (a + 1)) >> 8);
+				}
+				d[3] = (BYTE)((d[3] * (0x100 - a)) >> 8);
+			}
+		}
 	}
 }
 
@@ -72,16 +161,27 @@ void CompositionObject::RenderHdmv(SubPicDesc& spd, SubPicDesc* spdResized)
 		return;
 	}
 
+	if (!HaveBitmap()) {
+		DecodeHdmv();
+	}
+
+	DrawBitmap(spdResized ? *spdResized : spd, m_horizontal_position, m_vertical_position);
+}
+
+void CompositionObject::DecodeHdmv()
+{
+	InitBitmap();
+
 	CGolombBuffer	GBuffer (m_pRLEData, m_nRLEDataSize);
 	BYTE			bTemp;
 	BYTE			bSwitch;
 
 	BYTE			nPaletteIndex = 0;
 	SHORT			nCount;
-	SHORT			nX	= m_horizontal_position;
-	SHORT			nY	= m_vertical_position;
+	SHORT			nX	= 0;
+	SHORT			nY	= 0;
 
-	while ((nY < (m_vertical_position + m_height)) && !GBuffer.IsEOF()) {
+	while ((nY < m_height) && !GBuffer.IsEOF()) {
 		bTemp = GBuffer.ReadByte();
 
 		nPaletteIndex = bTemp;
@@ -98,12 +198,12 @@ void CompositionObject::RenderHdmv(SubPicDesc& spd, SubPicDesc* spdResized)
 
 		if (nCount > 0) {
 			if (nPaletteIndex != 0xFF) {	// Fully transparent (section 9.14.4.2.2.1.1)
-				FillSolidRect(spdResized ? *spdResized : spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+				FillBitmap(nX, nY, nCount, m_Colors[nPaletteIndex]);
 			}
 			nX += nCount;
 		} else {
 			nY++;
-			nX = m_horizontal_position;
+			nX = 0;
 		}
 	}
 }
@@ -114,6 +214,17 @@ void CompositionObject::RenderDvb(SubPicDesc& spd, SHORT nX, SHORT nY, SubPicDes
 		return;
 	}
 
+	if (!HaveBitmap()) {
+		DecodeDvb();
+	}
+
+	DrawBitmap(spdResized ? *spdResized : spd, nX, nY);
+}
+
+void CompositionObject::DecodeDvb()
+{
+	InitBitmap();
+
 	CGolombBuffer	gb(m_pRLEData, m_nRLEDataSize);
 	SHORT			sTopFieldLength;
 	SHORT			sBottomFieldLength;
@@ -121,11 +232,11 @@ void CompositionObject::RenderDvb(SubPicDesc& spd, SHORT nX, SHORT nY, SubPicDes
 	sTopFieldLength		= gb.ReadShort();
 	sBottomFieldLength	= gb.ReadShort();
 
-	DvbRenderField(spdResized ? *spdResized : spd, gb, nX, nY,   sTopFieldLength);
-	DvbRenderField(spdResized ? *spdResized : spd, gb, nX, nY+1, sBottomFieldLength);
+	DvbDecodeField(gb, 0, 0, sTopFieldLength);
+	DvbDecodeField(gb, 0, 1, sBottomFieldLength);
 }
 
-void CompositionObject::DvbRenderField(SubPicDesc& spd, CGolombBuffer& gb, SHORT nXStart, SHORT nYStart, SHORT nLength)
+void CompositionObject::DvbDecodeField(CGolombBuffer& gb, SHORT nXStart, SHORT nYStart, SHORT nLength)
 {
 	//FillSolidRect (spd, 0,  0, 300, 10, 0xFFFF0000);	// Red opaque
 	//FillSolidRect (spd, 0, 10, 300, 10, 0xCC00FF00);	// Green 80%
@@ -138,13 +249,13 @@ void CompositionObject::DvbRenderField(SubPicDesc& spd, CGolombBuffer& gb, SHORT
 		BYTE bType = gb.ReadByte();
 		switch (bType) {
 			case 0x10 :
-				Dvb2PixelsCodeString(spd, gb, nX, nY);
+				Dvb2PixelsCodeString(gb, nX, nY);
 				break;
 			case 0x11 :
-				Dvb4PixelsCodeString(spd, gb, nX, nY);
+				Dvb4PixelsCodeString(gb, nX, nY);
 				break;
 			case 0x12 :
-				Dvb8PixelsCodeString(spd, gb, nX, nY);
+				Dvb8PixelsCodeString(gb, nX, nY);
 				break;
 			case 0x20 :
 				gb.SkipBytes (2);
@@ -160,13 +271,13 @@ void CompositionObject::DvbRenderField(SubPicDesc& spd, CGolombBuffer& gb, SHORT
 				nY += 2;
 				break;
 			default :
-				DLog(L"DvbRenderField(): Unknown DVBSUB segment 0x%02x, offset %d", bType, gb.GetPos()-1);
+				DLog(L"DvbDecodeField(): Unknown DVBSUB segment 0x%02x, offset %d", bType, gb.GetPos()-1);
 				break;
 		}
 	}
 }
 
-void CompositionObject::Dvb2PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, SHORT& nX, SHORT& nY)
+void CompositionObject::Dvb2PixelsCodeString(CGolombBuffer& gb, SHORT& nX, SHORT& nY)
 {
 	BYTE	bTemp;
 	BYTE	nPaletteIndex = 0;
@@ -214,7 +325,7 @@ void CompositionObject::Dvb2PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
 		}
 
 		if (nCount>0) {
-			FillSolidRect(spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+			FillBitmap(nX, nY, nCount, m_Colors[nPaletteIndex]);
 			nX += nCount;
 		}
 	}
@@ -222,7 +333,7 @@ void CompositionObject::Dvb2PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
 	gb.BitByteAlign();
 }
 
-void CompositionObject::Dvb4PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, SHORT& nX, SHORT& nY)
+void CompositionObject::Dvb4PixelsCodeString(CGolombBuffer& gb, SHORT& nX, SHORT& nY)
 {
 	BYTE	bTemp;
 	BYTE	nPaletteIndex = 0;
@@ -277,7 +388,7 @@ void CompositionObject::Dvb4PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
 #endif
 
 		if (nCount>0) {
-			FillSolidRect(spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+			FillBitmap(nX, nY, nCount, m_Colors[nPaletteIndex]);
 			nX += nCount;
 		}
 	}
@@ -285,7 +396,7 @@ void CompositionObject::Dvb4PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
 	gb.BitByteAlign();
 }
 
-void CompositionObject::Dvb8PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, SHORT& nX, SHORT& nY)
+void CompositionObject::Dvb8PixelsCodeString(CGolombBuffer& gb, SHORT& nX, SHORT& nY)
 {
 	BYTE	bTemp;
 	BYTE	nPaletteIndex = 0;
@@ -317,7 +428,7 @@ void CompositionObject::Dvb8PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
 		}
 
 		if (nCount>0) {
-			FillSolidRect(spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+			FillBitmap(nX, nY, nCount, m_Colors[nPaletteIndex]);
 			nX += nCount;
 		}
 	}
@@ -343,11 +454,22 @@ void CompositionObject::RenderXSUB(SubPicDesc& spd)
 		return;
 	}
 
+	if (!HaveBitmap()) {
+		DecodeXSUB();
+	}
+
+	DrawBitmap(spd, m_horizontal_position, m_vertical_position);
+}
+
+void CompositionObject::DecodeXSUB()
+{
+	InitBitmap();
+
 	CGolombBuffer gb(m_pRLEData, m_nRLEDataSize);
 	BYTE nPaletteIndex = 0;
 	int  nCount;
-	int  nX = m_horizontal_position;
-	int  nY = m_vertical_position;
+	int  nX = 0;
+	int  nY = 0;
 
 	for (SHORT y = 0; y < m_height; y++) {
 		if (gb.IsEOF()) {
@@ -355,19 +477,19 @@ void CompositionObject::RenderXSUB(SubPicDesc& spd)
 		}
 		if (y == (m_height + 1) / 2) {
 			// interlaced: do odd lines
-			nY = m_vertical_position + 1;
+			nY = 1;
 		}
-		nX = m_horizontal_position;
-		while (nX < (m_horizontal_position + m_width)) {
+		nX = 0;
+		while (nX < m_width) {
 			int log2		= ff_log2_tab[gb.BitRead(8, true)];
 			nCount			= gb.BitRead(14 - 4 * (log2 >> 1));
-			nCount			= std::min(nCount, m_width - (nX - m_horizontal_position));
+			nCount			= std::min(nCount, m_width - nX);
 			nPaletteIndex	= gb.BitRead(2);
 			// count 0 - means till end of row
 			if (!nCount) {
-				nCount = m_width - (nX - m_horizontal_position);
+				nCount = m_width - nX;
 			}
-			FillSolidRect(spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+			FillBitmap(nX, nY, nCount, m_Colors[nPaletteIndex]);
 			nX += nCount;
 		}
 		// interlaced, skip every second line
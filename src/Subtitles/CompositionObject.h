@@ -1,5 +1,5 @@
 /*
- * (C) 2006-2016 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -90,8 +90,22 @@ private :
 	int		m_nColorNumber	= 0;
 	DWORD	m_Colors[256];
 
-	void	DvbRenderField(SubPicDesc& spd, CGolombBuffer& gb, SHORT nXStart, SHORT nYStart, SHORT nLength);
-	void	Dvb2PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, SHORT& nX, SHORT& nY);
-	void	Dvb4PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, SHORT& nX, SHORT& nY);
-	void	Dvb8PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, SHORT& nX, SHORT& nY);
+	// decoded object, ARGB colors from the palette, 0 for the pixels that are not drawn
+	std::vector<DWORD>	m_Bitmap;
+	SHORT				m_nBitmapWidth	= 0;
+	SHORT				m_nBitmapHeight	= 0;
+
+	bool	HaveBitmap() const { return !m_Bitmap.empty() && m_nBitmapWidth == m_width && m_nBitmapHeight == m_height; };
+	void	InitBitmap();
+	void	FillBitmap(int nX, int nY, int nCount, DWORD color);
+	void	DrawBitmap(SubPicDesc& spd, int nX, int nY);
+
+	void	DecodeHdmv();
+	void	DecodeDvb();
+	void	DecodeXSUB();
+
+	void	DvbDecodeField(CGolombBuffer& gb, SHORT nXStart, SHORT nYStart, SHORT nLength);
+	void	Dvb2PixelsCodeString(CGolombBuffer& gb, SHORT& nX, SHORT& nY);
+	void	Dvb4PixelsCodeString(CGolombBuffer& gb, SHORT& nX, SHORT& nY);
+	void	Dvb8PixelsCodeString(CGolombBuffer& gb, SHORT& nX, SHORT& nY);
 };
@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -158,14 +158,18 @@ void CWord::Paint(const CPoint& p, const CPoint& org)
 					}
 				}
 			} else {
-				if (!CreatePath()) {
-					return;
-				}
+				{
+					CRenderingStats::CTimer timer(m_renderingCaches.stats, CRenderingStats::STEP_OUTLINE);
+
+					if (!CreatePath()) {
+						return;
+					}
 
-				Transform(CPoint((org.x - p.x) * 8, (org.y - p.y) * 8));
+					Transform(CPoint((org.x - p.x) * 8, (org.y - p.y) * 8));
 
-				if (!ScanConvert()) {
-					return;
+					if (!ScanConvert()) {
+						return;
+					}
 				}
 
 				if (m_style.borderStyle == 0 && (m_style.outlineWidthX + m_style.outlineWidthY > 0)) {
@@ -181,6 +185,7 @@ void CWord::Paint(const CPoint& p, const CPoint& org)
 						}
 					}
 
+					CRenderingStats::CTimer timer(m_renderingCaches.stats, CRenderingStats::STEP_WIDEN);
 					if (!CreateWidenedRegion(rx, ry)) {
 						return;
 					}
@@ -197,11 +202,13 @@ void CWord::Paint(const CPoint& p, const CPoint& org)
 
 			m_fDrawn = true;
 
+			CRenderingStats::CTimer timer(m_renderingCaches.stats, CRenderingStats::STEP_RASTERIZE);
 			if (!Rasterize(p.x & 7, p.y & 7, m_style.fBlur, m_style.fGaussianBlur)) {
 				return;
 			}
 			m_renderingCaches.overlayCache.SetAt(overlayKey, m_pOverlayData);
 		} else if ((m_p.x & 7) != (p.x & 7) || (m_p.y & 7) != (p.y & 7)) {
+			CRenderingStats::CTimer timer(m_renderingCaches.stats, CRenderingStats::STEP_RASTERIZE);
 			Rasterize(p.x & 7, p.y & 7, m_style.fBlur, m_style.fGaussianBlur);
 			m_renderingCaches.overlayCache.SetAt(overlayKey, m_pOverlayData);
 		}
@@ -214,6 +221,40 @@ void CWord::Paint(const CPoint& p, const CPoint& org)
 	}
 }
 
+CRect CWord::Draw(SubPicDesc& spd, CRect& clipRect, byte* pAlphaMask, int xsub, int ysub, const DWORD* switchpts, bool fBody, bool fBorder)
+{
+	CRenderingStats::CTimer timer(m_renderingCaches.stats, CRenderingStats::STEP_DRAW);
+	return Rasterizer::Draw(spd, clipRect, pAlphaMask, xsub, ysub, switchpts, fBody, fBorder);
+}
+
+bool CWord::SetPath(const CPolygonPath& path)
+{
+	const int len = (int)path.typesOrg.GetCount();
+	if (len == 0) {
+		mPathPoints = 0;
+		return true;
+	}
+
+	if (mPathPoints != len) {
+		BYTE* pNewPathTypes = (BYTE*)realloc(mpPathTypes, len * sizeof(BYTE));
+		if (!pNewPathTypes) {
+			return false;
+		}
+		mpPathTypes = pNewPathTypes;
+		POINT* pNewPathPoints = (POINT*)realloc(mpPathPoints, len * sizeof(POINT));
+		if (!pNewPathPoints) {
+			return false;
+		}
+		mpPathPoints = pNewPathPoints;
+		mPathPoints = len;
+	}
+
+	memcpy(mpPathTypes, path.typesOrg.GetData(), len * sizeof(BYTE));
+	memcpy(mpPathPoints, path.pointsOrg.GetData(), len * sizeof(POINT));
+
+	return true;
+}
+
 bool CWord::CreateOpaqueBox()
 {
 	if (m_pOpaqueBox) {
@@ -450,7 +491,7 @@ CText::CText(STSStyle& style, CStringW str, int ktype, int kstart, int kend, dou
 
 	CTextDimsKey textDimsKey(m_str, m_style);
 	CTextDims textDims;
-	if (!renderingCaches.textDimsCache.Lookup(textDimsKey, textDims)) {
+	if (!CSharedRenderingCaches::GetInstance().LookupTextDims(textDimsKey, textDims)) {
 		CMyFont font(m_style);
 		m_ascent  = font.m_ascent;
 		m_descent = font.m_descent;
@@ -484,7 +525,7 @@ CText::CText(STSStyle& style, CStringW str, int ktype, int kstart, int kend, dou
 		textDims.descent = m_descent;
 		textDims.width   = m_width;
 
-		renderingCaches.textDimsCache.SetAt(textDimsKey, textDims);
+		CSharedRenderingCaches::GetInstance().SetTextDims(textDimsKey, textDims);
 	} else {
 		m_ascent  = textDims.ascent;
 		m_descent = textDims.descent;
@@ -508,6 +549,14 @@ bool CText::Append(CWord* w)
 
 bool CText::CreatePath()
 {
+	auto& sharedCaches = CSharedRenderingCaches::GetInstance();
+
+	CTextDimsKey textPathKey(m_str, m_style);
+	CPolygonPathSharedPtr pTextPath;
+	if (sharedCaches.LookupTextPath(textPathKey, pTextPath)) {
+		return SetPath(*pTextPath);
+	}
+
 	CMyFont font(m_style);
 
 	HFONT hOldFont = SelectFont(g_hDC, font);
@@ -546,6 +595,15 @@ bool CText::CreatePath()
 
 	SelectFont(g_hDC, hOldFont);
 
+	pTextPath = std::make_shared<CPolygonPath>();
+	if (mPathPoints > 0) {
+		pTextPath->typesOrg.SetCount(mPathPoints);
+		pTextPath->pointsOrg.SetCount(mPathPoints);
+		memcpy(pTextPath->typesOrg.GetData(), mpPathTypes, mPathPoints * sizeof(BYTE));
+		memcpy(pTextPath->pointsOrg.GetData(), mpPathPoints, mPathPoints * sizeof(POINT));
+	}
+	sharedCaches.SetTextPath(textPathKey, pTextPath);
+
 	return true;
 }
 
@@ -770,29 +828,11 @@ bool CPolygon::ParseStr()
 
 bool CPolygon::CreatePath()
 {
-	int len = m_pPolygonPath ? (int)m_pPolygonPath->typesOrg.GetCount() : 0;
-	if (len == 0) {
+	if (!m_pPolygonPath || m_pPolygonPath->typesOrg.IsEmpty()) {
 		return false;
 	}
 
-	if (mPathPoints != len) {
-		BYTE* pNewPathTypes = (BYTE*)realloc(mpPathTypes, len * sizeof(BYTE));
-		if (!pNewPathTypes) {
-			return false;
-		}
-		mpPathTypes = pNewPathTypes;
-		POINT* pNewPathPoints = (POINT*)realloc(mpPathPoints, len * sizeof(POINT));
-		if (!pNewPathPoints) {
-			return false;
-		}
-		mpPathPoints = pNewPathPoints;
-		mPathPoints = len;
-	}
-
-	memcpy(mpPathTypes, m_pPolygonPath->typesOrg.GetData(), len * sizeof(BYTE));
-	memcpy(mpPathPoints, m_pPolygonPath->pointsOrg.GetData(), len * sizeof(POINT));
-
-	return true;
+	return SetPath(*m_pPolygonPath);
 }
 
 // CClipper
@@ -1585,7 +1625,6 @@ CRenderedTextSubtitle::CRenderedTextSubtitle(CCritSec* pLock)
 	, m_bOverrideStyle(false)
 	, m_bOverridePlacement(false)
 	, m_overridePlacement(50, 90)
-	, m_webvtt_allow_clear(false)
 {
 	m_size = CSize(0, 0);
 
@@ -3068,6 +3107,8 @@ STDMETHODIMP CRenderedTextSubtitle::Render(SubPicDesc& spd, REFERENCE_TIME rt, d
 		return S_FALSE;
 	}
 
+	CRenderingStats::CTimer timer(m_renderingCaches.stats, CRenderingStats::STEP_FRAME);
+
 	// clear any cached subs that is behind current time
 	{
 		POSITION pos = m_subtitleCache.GetStartPosition();
@@ -78,7 +78,16 @@ struct SSATag;
 typedef std::shared_ptr<CAtlList<SSATag>> SSATagsList;
 typedef std::shared_ptr<CAlphaMask> CAlphaMaskSharedPtr;
 
+// memory used by the cached data, see RenderingCache.cpp
+template<> struct CRenderingCacheEntrySize<CPolygonPathSharedPtr> { size_t operator()(const CPolygonPathSharedPtr& value) const; };
+template<> struct CRenderingCacheEntrySize<SSATagsList> { size_t operator()(const SSATagsList& value) const; };
+template<> struct CRenderingCacheEntrySize<CEllipseSharedPtr> { size_t operator()(const CEllipseSharedPtr& value) const; };
+template<> struct CRenderingCacheEntrySize<COutlineDataSharedPtr> { size_t operator()(const COutlineDataSharedPtr& value) const; };
+template<> struct CRenderingCacheEntrySize<COverlayDataSharedPtr> { size_t operator()(const COverlayDataSharedPtr& value) const; };
+template<> struct CRenderingCacheEntrySize<CAlphaMaskSharedPtr> { size_t operator()(const CAlphaMaskSharedPtr& value) const; };
+
 typedef CRenderingCache<CTextDimsKey, CTextDims, CKeyTraits<CTextDimsKey>> CTextDimsCache;
+typedef CRenderingCache<CTextDimsKey, CPolygonPathSharedPtr, CKeyTraits<CTextDimsKey>> CTextPathCache;
 typedef CRenderingCache<CPolygonPathKey, CPolygonPathSharedPtr, CKeyTraits<CPolygonPathKey>> CPolygonCache;
 typedef CRenderingCache<CStringW, SSATagsList, CStringElementTraits<CStringW>> CSSATagsCache;
 typedef CRenderingCache<CEllipseKey, CEllipseSharedPtr, CKeyTraits<CEllipseKey>> CEllipseCache;
@@ -86,8 +95,44 @@ typedef CRenderingCache<COutlineKey, COutlineDataSharedPtr, CKeyTraits<COutlineK
 typedef CRenderingCache<COverlayKey, COverlayDataSharedPtr, CKeyTraits<COverlayKey>> COverlayCache;
 typedef CRenderingCache<CClipperKey, CAlphaMaskSharedPtr, CKeyTraits<CClipperKey>> CAlphaMaskCache;
 
+#define RENDERING_CACHES_MAX_BYTES (128 * MEGABYTE)
+#define SHARED_RENDERING_CACHES_MAX_BYTES (32 * MEGABYTE)
+
+// The text metrics and the untransformed text outlines depend only on the font and the text,
+// they are shared by all CRenderedTextSubtitle instances of the process.
+class CSharedRenderingCaches
+{
+	std::mutex m_mutex;
+
+	// Must be declared before the caches, they update it until they are destroyed
+	CRenderingCacheBudget m_budget;
+
+	CTextDimsCache m_textDimsCache;
+	CTextPathCache m_textPathCache;
+
+	// the caches are keyed by the font name, so they are cleared when the installed fonts change
+	UINT m_fontsVersion;
+
+	CSharedRenderingCaches();
+
+	void CheckFontsVersion();
+
+public:
+	static CSharedRenderingCaches& GetInstance();
+
+	bool LookupTextDims(const CTextDimsKey& key, CTextDims& textDims);
+	void SetTextDims(const CTextDimsKey& key, const CTextDims& textDims);
+
+	bool LookupTextPath(const CTextDimsKey& key, CPolygonPathSharedPtr& pTextPath);
+	void SetTextPath(const CTextDimsKey& key, const CPolygonPathSharedPtr& pTextPath);
+
+	void GetStatistics(CRenderingCacheBase::Statistics& textDims, CRenderingCacheBase::Statistics& textPath);
+};
+
 struct RenderingCaches {
-	CTextDimsCache textDimsCache;
+	// Must be declared first, the caches update it until they are destroyed
+	CRenderingCacheBudget budget;
+
 	CPolygonCache polygonCache;
 	CSSATagsCache SSATagsCache;
 	CEllipseCache ellipseCache;
@@ -97,14 +142,16 @@ struct RenderingCaches {
 	std::list<CAlphaMask> alphaMaskPool;
 	CAlphaMaskCache alphaMaskCache;
 
+	CRenderingStats stats;
+
 	RenderingCaches()
-		: textDimsCache(2048)
-		, polygonCache(2048)
-		, SSATagsCache(2048)
-		, ellipseCache(64)
-		, outlineCache(128)
-		, overlayCache(128)
-	, alphaMaskCache(128) {}
+		: budget(RENDERING_CACHES_MAX_BYTES)
+		, polygonCache(L"Polygon", 2048, &budget)
+		, SSATagsCache(L"SSATags", 2048, &budget)
+		, ellipseCache(L"Ellipse", 64, &budget)
+		, outlineCache(L"Outline", 1024, &budget)
+		, overlayCache(L"Overlay", 1024, &budget)
+		, alphaMaskCache(L"AlphaMask", 128, &budget) {}
 };
 
 class CMyFont : public CFont
@@ -137,6 +184,7 @@ protected:
 	CStringW m_str;
 
 	virtual bool CreatePath() PURE;
+	bool SetPath(const CPolygonPath& path);
 
 public:
 	bool m_fWhiteSpaceChar, m_fLineBreak;
@@ -158,6 +206,7 @@ public:
 	virtual bool Append(CWord* w);
 
 	void Paint(const CPoint& p, const CPoint& org);
+	CRect Draw(SubPicDesc& spd, CRect& clipRect, byte* pAlphaMask, int xsub, int ysub, const DWORD* switchpts, bool fBody, bool fBorder);
 
 	friend class COutlineKey;
 
@@ -508,7 +557,6 @@ public:
 	bool Init(CSize size, const CRect& vidrect); // will call Deinit()
 	void Deinit();
 
-	bool m_webvtt_allow_clear;
 	void SetSubtitleTypeFromGUID(GUID subtype);
 
 	DECLARE_IUNKNOWN
@@ -879,10 +879,18 @@ bool Rasterizer::Rasterize(int xsub, int ysub, int fBlur, double fGaussianBlur)
 
 			byte* src = m_pOutlineData->mWideOutline.empty() ? m_pOverlayData->mpOverlayBufferBody : m_pOverlayData->mpOverlayBufferBorder;
 
-			SeparableFilterX_SSE2(src, tmp, m_pOverlayData->mOverlayWidth, m_pOverlayData->mOverlayHeight, pitch,
-								  filter.kernel, filter.width, filter.divisor);
-			SeparableFilterY_SSE2(tmp, src, m_pOverlayData->mOverlayWidth, m_pOverlayData->mOverlayHeight, pitch,
-								  filter.kernel, filter.width, filter.divisor);
+			// the direct convolution is also the fallback when the prefix sums can't be allocated
+			const bool bBoxSums = filter.UseBoxSums(m_bUseAVX2);
+			if (!bBoxSums || !BoxSumFilterX(src, tmp, m_pOverlayData->mOverlayWidth, m_pOverlayData->mOverlayHeight, pitch,
+											filter.boxRadius, filter.boxCoeff, filter.divisor, m_bUseAVX2)) {
+				SeparableFilterX_SSE2(src, tmp, m_pOverlayData->mOverlayWidth, m_pOverlayData->mOverlayHeight, pitch,
+									  filter.kernel, filter.width, filter.divisor);
+			}
+			if (!bBoxSums || !BoxSumFilterY(tmp, src, m_pOverlayData->mOverlayWidth, m_pOverlayData->mOverlayHeight, pitch,
+											filter.boxRadius, filter.boxCoeff, filter.divisor, m_bUseAVX2)) {
+				SeparableFilterY_SSE2(tmp, src, m_pOverlayData->mOverlayWidth, m_pOverlayData->mOverlayHeight, pitch,
+									  filter.kernel, filter.width, filter.divisor);
+			}
 
 			_aligned_free(tmp);
 		}
@@ -1146,6 +1154,8 @@ namespace
 
 			const __m128i zero = _mm_setzero_si128();
 			const __m128i ones = _mm_set1_epi16(0x1);
+			const __m128i opaque = _mm_cmpeq_epi32(zero, zero);
+			const __m128i solid = _mm_set1_epi32(color & 0xFFFFFF);
 
 			const BYTE* alpha_end0 = alpha + (w & ~15);
 			const BYTE* alpha_end = alpha + w;
@@ -1153,12 +1163,25 @@ namespace
 			int i = 0;
 			for (; alpha < alpha_end0; alpha += 16, dst += 16 * 4, i += 16) {
 				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha));
+				a = calc_alpha_value(a, color, args..., i);
+
+				// Fully transparent spans leave dst untouched, fully opaque ones replace it
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, zero)) == 0xFFFF) {
+					continue;
+				}
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, opaque)) == 0xFFFF) {
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), solid);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), solid);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), solid);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 48), solid);
+					continue;
+				}
+
 				__m128i d1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
 				__m128i d2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + 16));
 				__m128i d3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + 32));
 				__m128i d4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + 48));
 
-				a = calc_alpha_value(a, color, args..., i);
 				__m128i ra = _mm_cmpeq_epi32(zero, zero);
 				ra = _mm_xor_si128(ra, a);
 				__m128i a1 = _mm_unpacklo_epi8(ra, a);
@@ -1197,6 +1220,13 @@ namespace
 
 			const int ROUNDING_ERR = 1 << (6 - 1);
 			const DWORD a_ = (alpha * (color >> 24) + ROUNDING_ERR) >> 6;
+			if (a_ == 0) {
+				return;
+			}
+			if (a_ == 0xFF) {
+				std::fill_n(reinterpret_cast<DWORD*>(dst), w, color & 0xFFFFFF);
+				return;
+			}
 			const __m128i a = _mm_set1_epi32(((a_ + 1) << 16) | (0x100 - a_));
 
 			const BYTE* dst_end0 = dst + ((4 * w) & ~63);
@@ -1337,6 +1367,8 @@ namespace
 
 			const __m256i zero = _mm256_setzero_si256();
 			const __m256i ones = _mm256_set1_epi16(1);
+			const __m256i opaque = _mm256_cmpeq_epi32(zero, zero);
+			const __m256i solid = _mm256_set1_epi32(color & 0xFFFFFF);
 
 			const BYTE* alpha_end0 = alpha + (w & ~31);
 			const BYTE* alpha_end1 = alpha + (w & ~15);
@@ -1348,13 +1380,25 @@ namespace
 			for (; alpha < alpha_end0; alpha += 32, dst += 32 * 4, i += 32) {
 				// TODO: Refactor memory allocation and use aligned loads
 				__m256i a = _mm256_lddqu_si256(reinterpret_cast<const __m256i*>(alpha));
+				a = calc_alpha_value(a, color, args..., i);
+
+				// Fully transparent spans leave dst untouched, fully opaque ones replace it
+				if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, zero)) == -1) {
+					continue;
+				}
+				if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, opaque)) == -1) {
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), solid);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32), solid);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 64), solid);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 96), solid);
+					continue;
+				}
 
 				__m256i d1 = _mm256_lddqu_si256(reinterpret_cast<const __m256i*>(dst));
 				__m256i d2 = _mm256_lddqu_si256(reinterpret_cast<const __m256i*>(dst + 32));
 				__m256i d3 = _mm256_lddqu_si256(reinterpret_cast<const __m256i*>(dst + 64));
 				__m256i d4 = _mm256_lddqu_si256(reinterpret_cast<const __m256i*>(dst + 96));
 
-				a = calc_alpha_value(a, color, args..., i);
 				a = _mm256_permutevar8x32_epi32(a, perm_mask);
 
 				__m256i ra = _mm256_cmpeq_epi32(zero, zero);
@@ -1448,6 +1492,13 @@ namespace
 
 			const int ROUNDING_ERR = 1 << (6 - 1);
 			const DWORD a_ = (alpha * (color >> 24) + ROUNDING_ERR) >> 6;
+			if (a_ == 0) {
+				return;
+			}
+			if (a_ == 0xFF) {
+				std::fill_n(reinterpret_cast<DWORD*>(dst), w, color & 0xFFFFFF);
+				return;
+			}
 			const __m256i a = _mm256_set1_epi32(((a_ + 1) << 16) | (0x100 - a_));
 
 			const BYTE* dst_end0 = dst + ((4 * w) & ~127);
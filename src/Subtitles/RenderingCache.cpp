@@ -1,5 +1,5 @@
 /*
- * (C) 2013-2022 see Authors.txt
+ * (C) 2013-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -21,6 +21,262 @@
 #include "stdafx.h"
 #include "RenderingCache.h"
 #include "RTS.h"
+#include "DSUtil/FontInstaller.h"
+
+//
+// CRenderingCacheBase
+//
+
+CRenderingCacheBase::CRenderingCacheBase(LPCWSTR name, size_t maxCount, CRenderingCacheBudget* pBudget)
+	: m_name(name)
+	, m_maxCount(maxCount)
+	, m_pBudget(pBudget)
+{
+	if (m_pBudget) {
+		m_pBudget->m_caches.emplace_back(this);
+	}
+}
+
+CRenderingCacheBase::~CRenderingCacheBase()
+{
+	if (m_pBudget) {
+		auto& caches = m_pBudget->m_caches;
+		caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+	}
+}
+
+CRenderingCacheBase::Statistics CRenderingCacheBase::GetStatistics() const
+{
+	return { m_nHits, m_nMisses, m_nEvictions, GetCount(), m_bytes };
+}
+
+void CRenderingCacheBase::LogStatistics() const
+{
+	DLogIf(m_nHits || m_nMisses, L"CRenderingCache(%s): %Iu hits (%Iu%%), %Iu misses, %Iu evictions, %Iu entries, %Iu KB",
+		   m_name, m_nHits, m_nHits * 100 / std::max(m_nHits + m_nMisses, (size_t)1), m_nMisses, m_nEvictions, GetCount(), m_bytes / KILOBYTE);
+}
+
+void CRenderingCacheBase::AddBytes(size_t bytes)
+{
+	m_bytes += bytes;
+	if (m_pBudget) {
+		m_pBudget->m_bytes += bytes;
+		m_pBudget->Trim();
+	}
+}
+
+void CRenderingCacheBase::RemoveBytes(size_t bytes)
+{
+	m_bytes -= bytes;
+	if (m_pBudget) {
+		m_pBudget->m_bytes -= bytes;
+	}
+}
+
+//
+// CRenderingCacheBudget
+//
+
+void CRenderingCacheBudget::Trim()
+{
+	while (m_bytes > m_maxBytes) {
+		// the most recently used entry of each cache is never removed, it was probably just added
+		CRenderingCacheBase* pLargest = nullptr;
+		for (const auto& pCache : m_caches) {
+			if (pCache->GetCount() > 1 && (!pLargest || pCache->m_bytes > pLargest->m_bytes)) {
+				pLargest = pCache;
+			}
+		}
+		if (!pLargest) {
+			break;
+		}
+
+		pLargest->RemoveOldest();
+	}
+}
+
+//
+// CSharedRenderingCaches
+//
+
+CSharedRenderingCaches::CSharedRenderingCaches()
+	: m_budget(SHARED_RENDERING_CACHES_MAX_BYTES)
+	, m_textDimsCache(L"SharedTextDims", 8192, &m_budget)
+	, m_textPathCache(L"SharedTextPath", 4096, &m_budget)
+	, m_fontsVersion(CFontInstaller::GetFontsVersion())
+{
+}
+
+void CSharedRenderingCaches::CheckFontsVersion()
+{
+	const UINT fontsVersion = CFontInstaller::GetFontsVersion();
+	if (fontsVersion != m_fontsVersion) {
+		m_fontsVersion = fontsVersion;
+		m_textDimsCache.Clear();
+		m_textPathCache.Clear();
+	}
+}
+
+CSharedRenderingCaches& CSharedRenderingCaches::GetInstance()
+{
+	static CSharedRenderingCaches sharedCaches;
+	return sharedCaches;
+}
+
+bool CSharedRenderingCaches::LookupTextDims(const CTextDimsKey& key, CTextDims& textDims)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	CheckFontsVersion();
+	return m_textDimsCache.Lookup(key, textDims);
+}
+
+void CSharedRenderingCaches::SetTextDims(const CTextDimsKey& key, const CTextDims& textDims)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	CheckFontsVersion();
+	m_textDimsCache.SetAt(key, textDims);
+}
+
+bool CSharedRenderingCaches::LookupTextPath(const CTextDimsKey& key, CPolygonPathSharedPtr& pTextPath)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	CheckFontsVersion();
+	return m_textPathCache.Lookup(key, pTextPath);
+}
+
+void CSharedRenderingCaches::SetTextPath(const CTextDimsKey& key, const CPolygonPathSharedPtr& pTextPath)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	CheckFontsVersion();
+	m_textPathCache.SetAt(key, pTextPath);
+}
+
+void CSharedRenderingCaches::GetStatistics(CRenderingCacheBase::Statistics& textDims, CRenderingCacheBase::Statistics& textPath)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	textDims = m_textDimsCache.GetStatistics();
+	textPath = m_textPathCache.GetStatistics();
+}
+
+#ifdef _DEBUG
+
+//
+// CRenderingStats
+//
+
+void CRenderingStats::AddTime(Step step, std::chrono::steady_clock::duration time)
+{
+	m_time[step] += time;
+	m_count[step]++;
+
+	if (step == STEP_FRAME) {
+		if (m_frameTimes.empty()) {
+			m_frameTimes.resize(FRAME_TIME_SLOTS + 1);
+		}
+		const auto slot = std::chrono::duration_cast<std::chrono::microseconds>(time).count() / 100;
+		m_frameTimes[std::min((size_t)slot, FRAME_TIME_SLOTS)]++;
+		m_maxFrameTime = std::max(m_maxFrameTime, time);
+	}
+}
+
+UINT64 CRenderingStats::GetFrameTimePercentile(size_t percent) const
+{
+	const size_t count = m_count[STEP_FRAME] * percent / 100;
+	size_t sum = 0;
+	for (size_t i = 0; i < FRAME_TIME_SLOTS; i++) {
+		sum += m_frameTimes[i];
+		if (sum > count) {
+			return (i + 1) * 100;
+		}
+	}
+
+	return std::chrono::duration_cast<std::chrono::microseconds>(m_maxFrameTime).count();
+}
+
+void CRenderingStats::LogStatistics() const
+{
+	if (!m_count[STEP_FRAME]) {
+		return;
+	}
+
+	auto ms = [](std::chrono::steady_clock::duration time) {
+		return (UINT64)std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+	};
+
+	DLog(L"CRenderingStats: %Iu frames, render time avg %I64u us, p50 %I64u us, p95 %I64u us, p99 %I64u us, max %I64u us",
+		 m_count[STEP_FRAME],
+		 (UINT64)std::chrono::duration_cast<std::chrono::microseconds>(m_time[STEP_FRAME]).count() / m_count[STEP_FRAME],
+		 GetFrameTimePercentile(50), GetFrameTimePercentile(95), GetFrameTimePercentile(99),
+		 (UINT64)std::chrono::duration_cast<std::chrono::microseconds>(m_maxFrameTime).count());
+	DLog(L"CRenderingStats: outline %I64u ms (%Iu), widen %I64u ms (%Iu), rasterize %I64u ms (%Iu), draw %I64u ms (%Iu), total %I64u ms",
+		 ms(m_time[STEP_OUTLINE]), m_count[STEP_OUTLINE],
+		 ms(m_time[STEP_WIDEN]), m_count[STEP_WIDEN],
+		 ms(m_time[STEP_RASTERIZE]), m_count[STEP_RASTERIZE],
+		 ms(m_time[STEP_DRAW]), m_count[STEP_DRAW],
+		 ms(m_time[STEP_FRAME]));
+}
+
+#endif
+
+//
+// CRenderingCacheEntrySize
+//
+
+size_t CRenderingCacheEntrySize<CPolygonPathSharedPtr>::operator()(const CPolygonPathSharedPtr& value) const
+{
+	if (!value) {
+		return 0;
+	}
+	return sizeof(CPolygonPath) + value->typesOrg.GetCount() * sizeof(BYTE) + value->pointsOrg.GetCount() * sizeof(CPoint);
+}
+
+size_t CRenderingCacheEntrySize<SSATagsList>::operator()(const SSATagsList& value) const
+{
+	if (!value) {
+		return 0;
+	}
+
+	size_t size = sizeof(CAtlList<SSATag>);
+	for (POSITION pos = value->GetHeadPosition(); pos; ) {
+		const SSATag& tag = value->GetNext(pos);
+		size += sizeof(SSATag) + tag.params.GetCount() * sizeof(CStringW) + tag.paramsInt.GetCount() * sizeof(int) + tag.paramsReal.GetCount() * sizeof(double);
+	}
+	return size;
+}
+
+size_t CRenderingCacheEntrySize<CEllipseSharedPtr>::operator()(const CEllipseSharedPtr& value) const
+{
+	if (!value) {
+		return 0;
+	}
+	// the arc and the intersection cache, both are about one value per line
+	return sizeof(CEllipse) + (2 * value->GetYRadius() + 1) * 2 * sizeof(int);
+}
+
+size_t CRenderingCacheEntrySize<COutlineDataSharedPtr>::operator()(const COutlineDataSharedPtr& value) const
+{
+	if (!value) {
+		return 0;
+	}
+	return sizeof(COutlineData) + (value->mOutline.capacity() + value->mWideOutline.capacity()) * sizeof(tSpanBuffer::value_type);
+}
+
+size_t CRenderingCacheEntrySize<COverlayDataSharedPtr>::operator()(const COverlayDataSharedPtr& value) const
+{
+	if (!value) {
+		return 0;
+	}
+	// body and border buffers
+	return sizeof(COverlayData) + 2 * size_t(value->mOverlayPitch) * value->mOverlayHeight;
+}
+
+size_t CRenderingCacheEntrySize<CAlphaMaskSharedPtr>::operator()(const CAlphaMaskSharedPtr& value) const
+{
+	if (!value) {
+		return 0;
+	}
+	return sizeof(CAlphaMask) + value->m_size;
+}
 
 template<typename T>
 bool NEARLY_EQ(T a, T b, T tol)
@@ -1,5 +1,5 @@
 /*
- * (C) 2013-2017 see Authors.txt
+ * (C) 2013-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -21,59 +21,206 @@
 #pragma once
 
 #include <atlcoll.h>
+#include <unordered_map>
+#include <chrono>
 
-template<typename K, typename V, class KTraits = CElementTraits<K>, class VTraits = CElementTraits<V>>
-class CRenderingCache : private CAtlMap<K, POSITION, KTraits>
+class CRenderingCacheBudget;
+
+class CRenderingCacheBase
+{
+	friend class CRenderingCacheBudget;
+
+protected:
+	LPCWSTR m_name;
+	size_t  m_maxCount;
+	size_t  m_bytes = 0;
+	CRenderingCacheBudget* m_pBudget;
+
+	// statistics
+	size_t m_nHits      = 0;
+	size_t m_nMisses    = 0;
+	size_t m_nEvictions = 0;
+
+	virtual size_t GetCount() const PURE;
+	virtual void RemoveOldest() PURE;
+
+	void LogStatistics() const;
+	void AddBytes(size_t bytes);
+	void RemoveBytes(size_t bytes);
+
+public:
+	CRenderingCacheBase(LPCWSTR name, size_t maxCount, CRenderingCacheBudget* pBudget);
+	virtual ~CRenderingCacheBase();
+
+	struct Statistics {
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		size_t count;
+		size_t bytes;
+	};
+	Statistics GetStatistics() const;
+};
+
+// Memory limit shared by several caches, the least recently used entries
+// of the cache taking the most memory are removed first when it is exceeded.
+class CRenderingCacheBudget
+{
+	friend class CRenderingCacheBase;
+
+	size_t m_maxBytes;
+	size_t m_bytes = 0;
+	std::vector<CRenderingCacheBase*> m_caches;
+
+	void Trim();
+
+public:
+	CRenderingCacheBudget(size_t maxBytes) : m_maxBytes(maxBytes) {};
+
+	size_t GetBytes() const { return m_bytes; }
+};
+
+// Time spent in the rendering steps, logged together with the cache statistics.
+// Only collected in debug builds, the timers do nothing in release builds.
+class CRenderingStats
+{
+public:
+	enum Step {
+		STEP_FRAME,     // whole CRenderedTextSubtitle::Render call
+		STEP_OUTLINE,   // path creation and scan conversion
+		STEP_WIDEN,     // outline widening
+		STEP_RASTERIZE, // overlay creation and blur
+		STEP_DRAW,      // blending into the subpicture
+		STEP_COUNT
+	};
+
+	// adds the time from its creation to its destruction to a step
+	class CTimer
+	{
+#ifdef _DEBUG
+		CRenderingStats& m_stats;
+		const Step m_step;
+		const std::chrono::steady_clock::time_point m_start;
+
+	public:
+		CTimer(CRenderingStats& stats, Step step)
+			: m_stats(stats), m_step(step), m_start(std::chrono::steady_clock::now()) {};
+		~CTimer() { m_stats.AddTime(m_step, std::chrono::steady_clock::now() - m_start); }
+#else
+	public:
+		CTimer(CRenderingStats&, Step) {};
+#endif
+	};
+
+#ifdef _DEBUG
+private:
+	std::chrono::steady_clock::duration m_time[STEP_COUNT] = {};
+	size_t m_count[STEP_COUNT] = {};
+
+	// frame times in 100 us steps, the last one counts all longer frames
+	static const size_t FRAME_TIME_SLOTS = 1000;
+	std::vector<UINT> m_frameTimes;
+	std::chrono::steady_clock::duration m_maxFrameTime = {};
+
+	UINT64 GetFrameTimePercentile(size_t percent) const; // in microseconds
+
+public:
+	~CRenderingStats() { LogStatistics(); }
+
+	void AddTime(Step step, std::chrono::steady_clock::duration time);
+	void LogStatistics() const;
+#endif
+};
+
+template<typename V>
+struct CRenderingCacheEntrySize {
+	size_t operator()(const V&) const { return sizeof(V); }
+};
+
+template<typename K, typename V, class KTraits = CElementTraits<K>, class VSize = CRenderingCacheEntrySize<V>>
+class CRenderingCache : public CRenderingCacheBase
 {
 private:
-	size_t m_maxSize;
-	struct CPositionValue {
-		POSITION pos;
-		V value;
+	struct CKeyHash {
+		size_t operator()(const K& key) const { return KTraits::Hash(key); }
 	};
-	CAtlList<CPositionValue> m_list;
+	struct CKeyEqual {
+		bool operator()(const K& key1, const K& key2) const { return KTraits::CompareElements(key1, key2); }
+	};
+
+	struct CEntry {
+		const K* key; // owned by m_map
+		V        value;
+		size_t   size;
+	};
+	std::list<CEntry> m_list; // most recently used first
+	std::unordered_map<K, typename std::list<CEntry>::iterator, CKeyHash, CKeyEqual> m_map;
+
+	static size_t GetEntrySize(const V& value) {
+		return VSize()(value) + sizeof(K) + sizeof(CEntry) + 4 * sizeof(void*);
+	}
+
+	size_t GetCount() const override {
+		return m_list.size();
+	}
+
+	void RemoveOldest() override {
+		const CEntry& entry = m_list.back();
+		RemoveBytes(entry.size);
+		m_map.erase(m_map.find(*entry.key));
+		m_list.pop_back();
+		m_nEvictions++;
+	}
 
 public:
-	CRenderingCache(size_t maxSize) : m_maxSize(maxSize) {};
+	CRenderingCache(LPCWSTR name, size_t maxCount, CRenderingCacheBudget* pBudget = nullptr)
+		: CRenderingCacheBase(name, maxCount, pBudget) {};
 
-	bool Lookup(typename KTraits::INARGTYPE key, _Out_ typename VTraits::OUTARGTYPE value) {
-		POSITION pos;
-		bool bFound = __super::Lookup(key, pos);
+	~CRenderingCache() {
+		LogStatistics();
+		Clear();
+	}
 
-		if (bFound) {
-			m_list.MoveToHead(pos);
-			value = m_list.GetHead().value;
+	bool Lookup(const K& key, V& value) {
+		auto it = m_map.find(key);
+		if (it == m_map.end()) {
+			m_nMisses++;
+			return false;
 		}
 
-		return bFound;
+		m_list.splice(m_list.begin(), m_list, it->second);
+		value = it->second->value;
+		m_nHits++;
+
+		return true;
 	};
 
-	POSITION SetAt(typename KTraits::INARGTYPE key, typename VTraits::INARGTYPE value) {
-		POSITION pos;
-		bool bFound = __super::Lookup(key, pos);
+	void SetAt(const K& key, const V& value) {
+		const size_t size = GetEntrySize(value);
 
-		if (bFound) {
-			m_list.MoveToHead(pos);
-			CPositionValue& posVal = m_list.GetHead();
-			pos = posVal.pos;
-			posVal.value = value;
+		auto it = m_map.find(key);
+		if (it != m_map.end()) {
+			m_list.splice(m_list.begin(), m_list, it->second);
+			CEntry& entry = *it->second;
+			RemoveBytes(entry.size);
+			entry.value = value;
+			entry.size = size;
 		} else {
-			if (m_list.GetCount() >= m_maxSize) {
-				__super::RemoveAtPos(m_list.GetTail().pos);
-				m_list.RemoveTailNoReturn();
+			while (m_list.size() >= m_maxCount && m_list.size()) {
+				RemoveOldest();
 			}
-			pos = __super::SetAt(key, m_list.AddHead());
-			CPositionValue& posVal = m_list.GetHead();
-			posVal.pos = pos;
-			posVal.value = value;
+			it = m_map.emplace(key, m_list.end()).first;
+			m_list.push_front({ &it->first, value, size });
+			it->second = m_list.begin();
 		}
 
-		return pos;
+		AddBytes(size);
 	};
 
 	void Clear() {
-		m_list.RemoveAll();
-		__super::RemoveAll();
+		RemoveBytes(m_bytes);
+		m_list.clear();
+		m_map.clear();
 	}
 };
 
@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -23,10 +23,13 @@
 #include "STS.h"
 #include <fstream>
 #include <regex>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "RealTextParser.h"
 #include "USFSubtitles.h"
-#include "RegexUtil.h"
 #include "DSUtil/std_helper.h"
+#include "DSUtil/FontInstaller.h"
 
 static struct htmlcolor {
 	LPCWSTR name;
@@ -276,7 +279,228 @@ static CStringW WebVTTCueStrip(CStringW& str)
 using WebVTTcolorData = struct _WebVTTcolorData { std::wstring color; std::wstring bg; bool applied = false; };
 using WebVTTcolorMap = std::map<std::wstring, WebVTTcolorData>;
 
-static void WebVTT2SSA(CStringW& str, CStringW& cueTags, WebVTTcolorMap clrMap)
+// splits "c.yellow.bg_black" into "c", ".yellow", ".bg_black"
+static void WebVTTSplitClasses(LPCWSTR p, std::vector<std::wstring>& classes)
+{
+	classes.clear();
+	while (*p) {
+		LPCWSTR begin = p;
+		if (*p == L'.') {
+			p++;
+			if (*p == L'\0' || *p == L'.') { // no class name after the dot
+				continue;
+			}
+		}
+		while (*p && *p != L'.') {
+			p++;
+		}
+		classes.emplace_back(begin, p - begin);
+	}
+}
+
+// returns the length of a tag we don't support at p (which points to '<'), or 0
+static int WebVTTUnsupportedTagLength(LPCWSTR p)
+{
+	auto isClassChar = [](WCHAR c) {
+		return c == L'.' || c == L'_' || iswalnum(c);
+	};
+	auto tagEnd = [p](LPCWSTR q) {
+		LPCWSTR end = wcschr(q, L'>');
+		return end ? (int)(end - p + 1) : 0;
+	};
+
+	LPCWSTR q = p + 1;
+	if (StartsWithStep(q, L"/c") || StartsWithStep(q, L"c")) { // <c.class> and </c.class>
+		while (isClassChar(*q)) {
+			q++;
+		}
+		return *q == L'>' ? (int)(q - p + 1) : 0;
+	}
+	if (*q == L'v' && (q[1] == L' ' || q[1] == L'.')) { // <v Speaker>
+		return tagEnd(q + 2);
+	}
+	if (StartsWith(q, L"lang")) { // <lang en>
+		return tagEnd(q + 4);
+	}
+	if (StartsWith(q, L"/v>")) {
+		return 4;
+	}
+	if (StartsWith(q, L"/lang>")) {
+		return 7;
+	}
+	if (iswdigit(q[0])) { // timestamp <00:00:00.000>
+		auto isDigits = [](LPCWSTR s, int n) {
+			for (int i = 0; i < n; i++) {
+				if (!iswdigit(s[i])) {
+					return false;
+				}
+			}
+			return true;
+		};
+		if (isDigits(q, 2) && q[2] == L':' && isDigits(q + 3, 2) && q[5] == L':' && isDigits(q + 6, 2)
+				&& q[8] && q[8] != L'\n' && q[8] != L'\r' && isDigits(q + 9, 3) && q[12] == L'>') {
+			return 14;
+		}
+	}
+
+	return 0;
+}
+
+static void WebVTTRemoveUnsupportedTags(CStringW& str)
+{
+	int tagPos = str.Find(L'<');
+	if (tagPos < 0) {
+		return;
+	}
+
+	CStringW out;
+	out.Preallocate(str.GetLength());
+
+	int copied = 0;
+	for (; tagPos >= 0; tagPos = str.Find(L'<', tagPos + 1)) {
+		const int len = WebVTTUnsupportedTagLength((LPCWSTR)str + tagPos);
+		if (len > 0) {
+			out.Append((LPCWSTR)str + copied, tagPos - copied);
+			copied = tagPos + len;
+			tagPos = copied - 1;
+		}
+	}
+
+	if (copied > 0) {
+		out.Append((LPCWSTR)str + copied, str.GetLength() - copied);
+		str = out;
+	}
+}
+
+// parses "attr: #hex;", "attr: name;" or "attr: rgb(r, g, b);" at the beginning of the style block
+static std::wstring WebVTTParseColor(LPCWSTR p, LPCWSTR attr)
+{
+	auto skipSpaces = [](LPCWSTR& s) {
+		while (iswspace(*s)) {
+			s++;
+		}
+	};
+	auto isAlnum = [](WCHAR c) {
+		return (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || (c >= L'0' && c <= L'9');
+	};
+
+	skipSpaces(p);
+	if (!StartsWithStep(p, attr)) {
+		return {};
+	}
+	skipSpaces(p);
+	if (*p != L':') {
+		return {};
+	}
+	p++;
+	skipSpaces(p);
+
+	LPCWSTR q = p;
+	if (*q == L'#') {
+		q++;
+	}
+	LPCWSTR begin = q;
+	while (isAlnum(*q)) {
+		q++;
+	}
+	LPCWSTR end = q;
+	skipSpaces(q);
+	if (*q == L';') {
+		return std::wstring(begin, end - begin);
+	}
+
+	if (!StartsWithStep(p, L"rgb")) {
+		return {};
+	}
+	skipSpaces(p);
+	if (*p != L'(') {
+		return {};
+	}
+	p++;
+
+	int rgb[3];
+	for (int i = 0; i < 3; i++) {
+		skipSpaces(p);
+		if (!iswdigit(*p)) {
+			return {};
+		}
+		LPWSTR numEnd;
+		rgb[i] = wcstol(p, &numEnd, 10) & 0xff;
+		p = numEnd;
+		skipSpaces(p);
+		if (*p != (i < 2 ? L',' : L')')) {
+			return {};
+		}
+		p++;
+	}
+	skipSpaces(p);
+	if (*p != L';') {
+		return {};
+	}
+
+	CStringW clr;
+	clr.Format(L"%x", (rgb[0] << 16) + (rgb[1] << 8) + rgb[2]);
+	return clr.GetString();
+}
+
+static bool WebVTTParseColors(LPCWSTR styles, WebVTTcolorData& colorData)
+{
+	colorData.color = WebVTTParseColor(styles, L"color");
+	colorData.bg = WebVTTParseColor(styles, L"background-color");
+	if (colorData.bg.empty()) {
+		colorData.bg = WebVTTParseColor(styles, L"background");
+	}
+	return !colorData.color.empty() || !colorData.bg.empty();
+}
+
+// collects the colors of "::cue { ... }" and "::cue(selector) { ... }" blocks
+static void WebVTTParseStyleBlock(const CStringW& styleStr, WebVTTcolorMap& cueColors)
+{
+	std::wstring defaultStyles; // only the last default cue style is used
+	bool bDefault = false;
+
+	for (int pos = styleStr.Find(L"::cue"); pos >= 0; pos = styleStr.Find(L"::cue", pos + 1)) {
+		LPCWSTR p = (LPCWSTR)styleStr + pos + 5;
+
+		std::wstring selector;
+		if (*p == L'(') {
+			LPCWSTR end = wcschr(++p, L')');
+			if (!end || end == p) {
+				continue;
+			}
+			selector.assign(p, end - p);
+			p = end + 1;
+		}
+		while (iswspace(*p)) {
+			p++;
+		}
+		if (*p != L'{') {
+			continue;
+		}
+		LPCWSTR end = wcschr(++p, L'}');
+		if (!end) {
+			continue;
+		}
+
+		if (selector.empty()) {
+			defaultStyles.assign(p, end - p);
+			bDefault = true;
+		} else {
+			WebVTTcolorData colorData;
+			if (WebVTTParseColors(std::wstring(p, end - p).c_str(), colorData)) {
+				cueColors[selector] = colorData;
+			}
+		}
+		pos = (int)(end - (LPCWSTR)styleStr);
+	}
+
+	WebVTTcolorData colorData;
+	if (bDefault && WebVTTParseColors(defaultStyles.c_str(), colorData)) {
+		cueColors[L"::cue"] = colorData;
+	}
+}
+
+static void WebVTT2SSA(CStringW& str, CStringW& cueTags, const WebVTTcolorMap& clrMap)
 {
 	std::vector<WebVTTcolorData> styleStack;
 	auto applyStyle = [&styleStack, &str](std::wstring clr, std::wstring bg, int endTag, bool restoring = false) {
@@ -311,13 +535,15 @@ static void WebVTT2SSA(CStringW& str, CStringW& cueTags, WebVTTcolorMap clrMap)
 	};
 
 	std::wstring clr, bg;
-	if (clrMap.count(L"::cue")) { //default cue style
-		WebVTTcolorData colorData = clrMap[L"::cue"];
-		clr = colorData.color;
-		bg = colorData.bg;
+	auto it = clrMap.find(L"::cue");
+	if (it != clrMap.cend()) { //default cue style
+		clr = it->second.color;
+		bg = it->second.bg;
 		applyStyle(clr, bg, -1);
 	}
 
+	std::vector<std::wstring> classes;
+
 	int tagPos = str.Find(L"<");
 	while (tagPos >= 0) {
 		int endTag = str.Find(L">", tagPos);
@@ -348,27 +574,25 @@ static void WebVTT2SSA(CStringW& str, CStringW& cueTags, WebVTTcolorMap clrMap)
 
 		int dotPos = inner.Find(L".");
 		if (dotPos < 0) {//it's a simple tag, so we can apply a single style to it, if it exists
-			if (clrMap.count(inner.GetString())) {
-				WebVTTcolorData colorData = clrMap[inner.GetString()];
-				clr = colorData.color;
-				bg = colorData.bg;
+			it = clrMap.find(inner.GetString());
+			if (it != clrMap.cend()) {
+				clr = it->second.color;
+				bg = it->second.bg;
 			}
 		}
 		else { //could find multiple classes
-			RegexUtil::wregexResults results;
-			std::wregex clsPattern(LR"((\.?[^\.]+))");
-			RegexUtil::wstringMatch(clsPattern, (const wchar_t*)inner, results);
-			if (results.size() > 1) {
-				std::wstring type = results[0][0];
-
-				for (auto iter = results.begin() + 1; iter != results.end(); ++iter) { //loop through all classes--whichever is last gets precedence
-					std::wstring cls = (*iter)[0];
+			WebVTTSplitClasses(inner, classes);
+			if (classes.size() > 1) {
+				const std::wstring& type = classes[0];
+
+				for (auto iter = classes.cbegin() + 1; iter != classes.cend(); ++iter) { //loop through all classes--whichever is last gets precedence
+					const std::wstring& cls = *iter;
 					WebVTTcolorData colorData;
-					if (clrMap.count(type + cls)) {
-						colorData = clrMap[type + cls];
+					if ((it = clrMap.find(type + cls)) != clrMap.cend()) {
+						colorData = it->second;
 					}
-					else if (clrMap.count(cls)) {
-						colorData = clrMap[cls];
+					else if ((it = clrMap.find(cls)) != clrMap.cend()) {
+						colorData = it->second;
 					}
 					if (colorData.color != L"") {
 						clr = colorData.color;
@@ -393,19 +617,9 @@ static void WebVTT2SSA(CStringW& str, CStringW& cueTags, WebVTTcolorMap clrMap)
 		str.Replace(L"</u>", L"{\\u}");
 	}
 
-	if (str.Find(L'<') >= 0) {
-		std::wstring stdTmp(str);
-
-		// remove tags we don't support
-		stdTmp = std::regex_replace(stdTmp, std::wregex(L"<c[.\\w\\d]*>"), L"");
-		stdTmp = std::regex_replace(stdTmp, std::wregex(L"</c[.\\w\\d]*>"), L"");
-		stdTmp = std::regex_replace(stdTmp, std::wregex(L"<\\d\\d:\\d\\d:\\d\\d.\\d\\d\\d>"), L"");
-		stdTmp = std::regex_replace(stdTmp, std::wregex(L"<v[ .][^>]*>"), L"");
-		stdTmp = std::regex_replace(stdTmp, std::wregex(L"</v>"), L"");
-		stdTmp = std::regex_replace(stdTmp, std::wregex(L"<lang[^>]*>"), L"");
-		stdTmp = std::regex_replace(stdTmp, std::wregex(L"</lang>"), L"");
-		str = stdTmp.c_str();
-	}
+	// remove tags we don't support
+	WebVTTRemoveUnsupportedTags(str);
+
 	if (str.Find(L'&') >= 0) {
 		str.Replace(L"&lt;", L"<");
 		str.Replace(L"&gt;", L">");
@@ -416,20 +630,21 @@ static void WebVTT2SSA(CStringW& str, CStringW& cueTags, WebVTTcolorMap clrMap)
 	}
 
 	if (!cueTags.IsEmpty()) {
-		std::wstring stdTmp(cueTags);
-		std::wregex alignRegex(L"align:(start|left|center|middle|end|right)");
-		std::wsmatch match;
-
-		if (std::regex_search(stdTmp, match, alignRegex)) {
-			if (match[1] == L"start" || match[1] == L"left") {
+		for (int pos = cueTags.Find(L"align:"); pos >= 0; pos = cueTags.Find(L"align:", pos + 1)) {
+			LPCWSTR value = (LPCWSTR)cueTags + pos + 6;
+			if (StartsWith(value, L"start") || StartsWith(value, L"left")) {
 				str = L"{\\an1}" + str;
 			}
-			else if (match[1] == L"center" || match[1] == L"middle") {
+			else if (StartsWith(value, L"center") || StartsWith(value, L"middle")) {
 				str = L"{\\an2}" + str;
 			}
-			else {
+			else if (StartsWith(value, L"end") || StartsWith(value, L"right")) {
 				str = L"{\\an3}" + str;
 			}
+			else {
+				continue;
+			}
+			break;
 		}
 	}
 }
@@ -506,58 +721,7 @@ static bool OpenVTT(CTextFile* file, CSimpleTextSubtitle& ret) {
 			startComment = styleStr.Find(L"/*");
 		}
 
-		if (!styleStr.IsEmpty()) {
-			auto parseColor = [](std::wstring styles, std::wstring attr = L"color") {
-				//we only support color styles for now
-				std::wregex clrPat(LR"(^\s*)" + attr + LR"(\s*:\s*#?([a-zA-Z0-9]*)\s*;)"); //e.g., 0xffffff or white
-				std::wregex rgbPat(LR"(^\s*)" + attr + LR"(\s*:\s*rgb\s*\(\s*([0-9]+)\s*,\s*([0-9]+)\s*,\s*([0-9]+)\s*\)\s*;)");
-				std::wsmatch match;
-				std::wstring clrStr;
-				if (std::regex_search(styles, match, clrPat)) {
-					clrStr = match[1];
-				}
-				else if (std::regex_search(styles, match, rgbPat)) {
-					int r = stoi(match[1]) & 0xff;
-					int g = stoi(match[2]) & 0xff;
-					int b = stoi(match[3]) & 0xff;
-					DWORD clr = (r << 16) + (g << 8) + b;
-					std::wstringstream hexClr;
-					hexClr << std::hex << clr;
-					clrStr = hexClr.str();
-				}
-				return clrStr;
-			};
-
-			RegexUtil::wregexResults results;
-			std::wregex cueDefPattern(LR"(::cue\s*\{([^}]*)\})"); //default cue style
-			RegexUtil::wstringMatch(cueDefPattern, (const wchar_t*)styleStr, results);
-			if (results.size() > 0) {
-				auto iter = results[results.size() - 1];
-				std::wstring clr, bgClr;
-				clr = parseColor(iter[0]);
-				bgClr = parseColor(iter[0], L"background-color");
-				if (bgClr == L"") {
-					bgClr = parseColor(iter[0], L"background");
-				}
-				if (clr != L"" || bgClr != L"") {
-					cueColors[L"::cue"] = WebVTTcolorData({ clr, bgClr });
-				}
-			}
-
-			std::wregex cuePattern(LR"(::cue\(([^)]+)\)\s*\{([^}]*)\})");
-			RegexUtil::wstringMatch(cuePattern, (const wchar_t*)styleStr, results);
-			for (const auto& iter : results) {
-				std::wstring clr, bgClr;
-				clr = parseColor(iter[1]);
-				bgClr = parseColor(iter[1], L"background-color");
-				if (bgClr == L"") {
-					bgClr = parseColor(iter[1], L"background");
-				}
-				if (clr != L"" || bgClr != L"") {
-					cueColors[iter[0]] = WebVTTcolorData({ clr, bgClr });
-				}
-			}
-		}
+		WebVTTParseStyleBlock(styleStr, cueColors);
 	};
 
 	CStringW lastStr, lastBuff;
@@ -814,26 +978,247 @@ static CString TTML2SSA(CString str)
 	return str;
 }
 
+// reads "<number>[.<fraction>]", returns false if there are no digits
+static bool ParseTTMLNumber(LPCWSTR& s, double& value)
+{
+	LPCWSTR start = s;
+	value = 0;
+	for (; *s >= L'0' && *s <= L'9'; s++) {
+		value = value * 10 + (*s - L'0');
+	}
+	if (*s == L'.') {
+		s++;
+		for (double scale = 0.1; *s >= L'0' && *s <= L'9'; s++, scale /= 10) {
+			value += (*s - L'0') * scale;
+		}
+	}
+
+	return s > start;
+}
+
+// the time base set by the ttp: parameters of the root element
+struct TTMLTimeBase {
+	double tickRate     = 10000000;
+	double frameRate    = 30;
+	double subFrameRate = 1;
+};
+
+// clock time "hh:mm:ss[.fraction]" or "hh:mm:ss:frames[.subframes]",
+// or offset time "<number>(h|m|s|ms|f|t)" in milliseconds, -1 if not supported
+static int TTMLTimeToMs(const std::wstring& str, const TTMLTimeBase& timeBase)
+{
+	auto ParseDigits = [](LPCWSTR& s, double& value) {
+		LPCWSTR start = s;
+		value = 0;
+		for (; *s >= L'0' && *s <= L'9'; s++) {
+			value = value * 10 + (*s - L'0');
+		}
+		return s > start;
+	};
+
+	LPCWSTR s = str.c_str();
+	while (*s == L' ') {
+		s++;
+	}
+
+	double value;
+	if (!ParseTTMLNumber(s, value)) {
+		return -1;
+	}
+
+	double ms = -1;
+	if (*s == L':') {
+		double mm, ss;
+		if (!ParseTTMLNumber(++s, mm) || *s != L':' || !ParseTTMLNumber(++s, ss)) {
+			return -1;
+		}
+		ms = ((value * 60 + mm) * 60 + ss) * 1000;
+
+		if (*s == L':') {
+			double frames, subFrames = 0;
+			if (!ParseDigits(++s, frames) || (*s == L'.' && !ParseDigits(++s, subFrames))
+					|| timeBase.frameRate <= 0 || timeBase.subFrameRate <= 0) {
+				return -1;
+			}
+			ms += (frames + subFrames / timeBase.subFrameRate) * 1000 / timeBase.frameRate;
+		}
+		if (*s) {
+			return -1;
+		}
+	} else if (wcscmp(s, L"h") == 0) {
+		ms = value * 60 * 60 * 1000;
+	} else if (wcscmp(s, L"m") == 0) {
+		ms = value * 60 * 1000;
+	} else if (wcscmp(s, L"s") == 0) {
+		ms = value * 1000;
+	} else if (wcscmp(s, L"ms") == 0) {
+		ms = value;
+	} else if (wcscmp(s, L"f") == 0 && timeBase.frameRate > 0) {
+		ms = value * 1000 / timeBase.frameRate;
+	} else if (wcscmp(s, L"t") == 0 && timeBase.tickRate > 0) {
+		ms = value * 1000 / timeBase.tickRate;
+	} else {
+		return -1;
+	}
+
+	return (int)std::lround(ms);
+}
+
+class CTTMLHandler : public CXmlSaxParser::Handler
+{
+	CSimpleTextSubtitle& m_sts;
+
+	TTMLTimeBase m_timeBase;
+	size_t m_level = 0;
+	size_t m_bodyLevel = 0;
+	size_t m_pLevel = 0;
+
+	int m_begin = -1;
+	int m_end = -1;
+	CStringW m_text;
+
+public:
+	CTTMLHandler(CSimpleTextSubtitle& sts) : m_sts(sts) {}
+
+	void StartElement(const std::wstring& name, const CXmlSaxParser::Attributes& attribs) override
+	{
+		const auto localName = CXmlSaxParser::LocalName(name);
+		m_level++;
+
+		if (m_pLevel) {
+			// the text conversion handles the line breaks, spans are not styled,
+			// other elements keep their attributes for the tags like <font color="...">
+			if (localName == L"br") {
+				m_text += L"<br/>";
+			} else if (localName != L"span") {
+				m_text.AppendFormat(L"<%s", localName.c_str());
+				for (const auto& attrib : attribs) {
+					const wchar_t quote = attrib.value.find(L'"') == std::wstring::npos ? L'"' : L'\'';
+					m_text.AppendFormat(L" %s=%c%s%c", attrib.name.c_str(), quote, attrib.value.c_str(), quote);
+				}
+				m_text += L'>';
+			}
+		} else if (m_level == 1 && localName == L"tt") {
+			double frameRateMultiplier = 1;
+			for (const auto& attrib : attribs) {
+				const auto attribName = CXmlSaxParser::LocalName(attrib.name);
+				if (attribName == L"tickRate") {
+					m_timeBase.tickRate = _wtof(attrib.value.c_str());
+				} else if (attribName == L"frameRate") {
+					m_timeBase.frameRate = _wtof(attrib.value.c_str());
+				} else if (attribName == L"subFrameRate") {
+					m_timeBase.subFrameRate = _wtof(attrib.value.c_str());
+				} else if (attribName == L"frameRateMultiplier") {
+					// "numerator denominator"
+					int numerator, denominator;
+					if (swscanf_s(attrib.value.c_str(), L"%d %d", &numerator, &denominator) == 2 && numerator > 0 && denominator > 0) {
+						frameRateMultiplier = (double)numerator / denominator;
+					}
+				}
+			}
+			m_timeBase.frameRate *= frameRateMultiplier;
+		} else if (localName == L"body") {
+			m_bodyLevel = m_level;
+		} else if (m_bodyLevel && localName == L"p") {
+			m_pLevel = m_level;
+			m_text.Empty();
+
+			auto GetTime = [&](LPCWSTR attrib) {
+				const auto value = CXmlSaxParser::FindAttribute(attribs, attrib);
+				return value ? TTMLTimeToMs(*value, m_timeBase) : -1;
+			};
+
+			m_begin = GetTime(L"begin");
+			m_end = GetTime(L"end");
+			if (m_begin != -1 && m_end == -1) {
+				const int duration = GetTime(L"dur");
+				if (duration != -1) {
+					m_end = m_begin + duration;
+				}
+			}
+		}
+	}
+
+	void EndElement(const std::wstring& name) override
+	{
+		if (m_pLevel) {
+			const auto localName = CXmlSaxParser::LocalName(name);
+			if (m_level == m_pLevel) {
+				m_pLevel = 0;
+				FastTrim(m_text);
+				if (m_begin != -1 && m_end > m_begin && !m_text.IsEmpty()) {
+					m_sts.Add(TTML2SSA(m_text), m_begin, m_end);
+				}
+			} else if (localName != L"br" && localName != L"span") {
+				m_text.AppendFormat(L"</%s>", localName.c_str());
+			}
+		} else if (m_level == m_bodyLevel) {
+			m_bodyLevel = 0;
+		}
+
+		m_level--;
+	}
+
+	void Characters(const std::wstring& text) override
+	{
+		if (m_pLevel) {
+			// the default XML white space handling of TTML, line breaks and indents become single spaces
+			for (const auto c : text) {
+				if (c == L' ' || c == L'\t' || c == L'\r' || c == L'\n') {
+					if (!m_text.IsEmpty() && m_text[m_text.GetLength() - 1] != L' ') {
+						m_text += L' ';
+					}
+				} else {
+					m_text += c;
+				}
+			}
+		}
+	}
+};
+
+// position of the start tag of the root element "tt", with or without a namespace prefix, -1 if not found
+static int FindTTMLRoot(const CString& str)
+{
+	for (int pos = str.Find(L'<'); pos != -1; pos = str.Find(L'<', pos + 1)) {
+		LPCWSTR s = str.GetString() + pos + 1;
+		LPCWSTR localName = s;
+		while (iswalnum(*s) || *s == L'_' || *s == L'-' || *s == L'.' || *s == L':') {
+			if (*s == L':') {
+				localName = s + 1;
+			}
+			s++;
+		}
+		if (s - localName == 2 && wcsncmp(localName, L"tt", 2) == 0
+				&& (*s == L' ' || *s == L'\t' || *s == L'>' || *s == L'\0')) {
+			return pos;
+		}
+	}
+
+	return -1;
+}
+
 static bool OpenTTML(CTextFile* file, CSimpleTextSubtitle& ret)
 {
+	const ULONGLONG pos = file->GetPosition();
+
 	CString buff;
 
 	if (!file->ReadString(buff)) {
 		return false;
 	}
 	FastTrim(buff);
-	if (buff.Find(L"<?xml") != 0 && buff.Find(L"<tt ") != 0) {
+	if (buff.Find(L"<?xml") != 0 && FindTTMLRoot(buff) != 0) {
 		return false;
 	}
 
-	if (buff.Find(L"<tt ") == -1) {
+	if (FindTTMLRoot(buff) == -1) {
 		for (unsigned line = 0; line < 10 && file->ReadString(buff); ++line) {
 			FastTrim(buff);
 			if (buff.IsEmpty()) {
 				continue;
 			}
 
-			if (buff.Find(L"<tt ") == -1) {
+			if (FindTTMLRoot(buff) == -1) {
 				continue;
 			}
 
@@ -841,104 +1226,28 @@ static bool OpenTTML(CTextFile* file, CSimpleTextSubtitle& ret)
 		}
 	}
 
-	if (buff.Find(L"<tt ") != -1) {
-		CString tmp(buff);
+	if (FindTTMLRoot(buff) == -1) {
+		return false;
+	}
 
-		while (file->ReadString(buff)) {
-			FastTrim(buff);
-			if (buff.IsEmpty()) {
-				continue;
-			}
+	// stream the document through the parser, only the current line is kept in memory
+	file->Seek(pos, CFile::begin);
 
-			tmp.Append(buff);
-		}
-
-		if (tmp.Find(L"</tt>") != -1) {
-			const auto body = RegExpParse(tmp.GetString(), LR"(<body[^>]*?>(.*)</body>)");
-			if (!body.IsEmpty()) {
-				const std::wregex regex(LR"(<p(.*?)</p>)");
-
-				std::wcmatch match;
-				auto body_text = body.GetString();
-				while (std::regex_search(body_text, match, regex)) {
-					if (match.size() == 2) {
-						CString line(match[1].first, match[1].length());
-
-						auto ParseTime = [](LPCWSTR buffer, LPCWSTR regexp) {
-							int time = -1;
-
-							const std::wregex regex(regexp);
-							std::wcmatch match;
-							if (std::regex_search(buffer, match, regex)) {
-								if (match.size() == 5) {
-									int hh = match[1].matched ? _wtoi(match[1].first) : 0;
-									int mm = match[2].matched ? _wtoi(match[2].first) : 0;
-									int ss = match[3].matched ? _wtoi(match[3].first) : 0;
-									int ms = match[3].matched ? _wtoi(match[4].first) : 0;
-
-									time = (((hh * 60 + mm) * 60) + ss) * 1000 + ms;
-								} else if (match.size() == 3) {
-									int ss = match[1].matched ? _wtoi(match[1].first) : 0;
-									int ms = match[2].matched ? _wtoi(match[2].first) : 0;
-
-									time = ss * 1000 + ms;
-								} else if (match.size() == 2) {
-									time = match[1].matched ? _wtoi(match[1].first) / 10000 : -1;
-								}
-							}
-
-							return time;
-						};
-
-						int time_end = -1;
-						int time_begin = ParseTime(line.GetString(), LR"(begin=\"(\d{2}):(\d{2}):(\d{2}).(\d{2,3})\")");
-						if (time_begin != -1) {
-							time_end = ParseTime(line.GetString(), LR"(end=\"(\d{2}):(\d{2}):(\d{2}).(\d{2,3})\")");
-							if (time_end == -1) {
-								int time_duration = ParseTime(line.GetString(), LR"(dur=\"(\d{2}):(\d{2}):(\d{2}).(\d{2,3})\")");
-								if (time_duration != -1) {
-									time_end = time_begin + time_duration;
-								}
-							}
-						}
-						if (time_begin == -1) {
-							time_begin = ParseTime(line.GetString(), LR"(begin=\"(\d+)\.?(\d{1,3})?s\")");
-							if (time_begin != -1) {
-								time_end = ParseTime(line.GetString(), LR"(end=\"(\d+)\.?(\d{1,3})?s\")");
-								if (time_end == -1) {
-									int time_duration = ParseTime(line.GetString(), LR"(dur=\"(\d+)\.?(\d{1,3})?s\")");
-									if (time_duration != -1) {
-										time_end = time_begin + time_duration;
-									}
-								}
-							}
-						}
-						if (time_begin == -1) {
-							time_begin = ParseTime(line.GetString(), LR"(begin=\"(\d+)t\")");
-							if (time_begin != -1) {
-								time_end = ParseTime(line.GetString(), LR"(end=\"(\d+)t\")");
-								if (time_end == -1) {
-									int time_duration = ParseTime(line.GetString(), LR"(dur=\"(\d+)t\")");
-									if (time_duration != -1) {
-										time_end = time_begin + time_duration;
-									}
-								}
-							}
-						}
-						if (time_begin != -1 && time_end > time_begin) {
-							auto text = RegExpParse(line.GetString(), LR"(>(.+))");
-							if (!text.IsEmpty()) {
-								ret.Add(TTML2SSA(text), time_begin, time_end);
-							}
-						}
-					}
+	CTTMLHandler handler(ret);
+	CXmlSaxParser parser(handler);
 
-					body_text = match[0].second;
-				}
-			}
+	while (file->ReadString(buff)) {
+		buff += L'\n';
+		if (!parser.Parse(buff.GetString(), buff.GetLength())) {
+			return false;
 		}
 	}
 
+	// a truncated document is not complete
+	if (!parser.Finish()) {
+		return false;
+	}
+
 	return !ret.IsEmpty();
 }
 
@@ -1703,9 +2012,13 @@ static bool LoadFont(const CString& font)
 			}
 		}
 
-		return !!AddFontResourceW(fn);
+		if (!AddFontResourceW(fn)) {
+			return false;
+		}
 	}
 
+	CFontInstaller::FontsChanged();
+
 	return true;
 }
 
@@ -1754,6 +2067,132 @@ static bool LoadUUEFont(CTextFile* file)
 	return cnt ? true : false;
 }
 
+#define SSA_DIALOGUES_BATCH        16384 // dialogue lines collected before they are parsed and added
+#define SSA_DIALOGUES_PARALLEL_MIN 2048  // fewer dialogue lines are parsed on the calling thread
+#define SSA_DIALOGUES_CHUNK        256   // dialogue lines parsed by a worker at once
+
+struct SSADialogue {
+	CStringW  line;
+	ULONGLONG endPos = 0; // file position after the line, reported on a syntax error
+
+	CStringW str;
+	CString  style, actor, effect;
+	CRect    marginRect;
+	int      start = 0, end = 0, layer = 0;
+};
+
+static bool ParseSSADialogue(SSADialogue& dialogue, const int version)
+{
+	LPCWSTR pszBuff = dialogue.line;
+	int nBuffLength = dialogue.line.GetLength();
+
+	try {
+		int hh1, mm1, ss1, ms1_div10, hh2, mm2, ss2, ms2_div10, layer = 0;
+		CRect marginRect;
+
+		GetStrW(pszBuff, nBuffLength, L':');			/* Dialogue: */
+		if (version <= 4) {
+			GetStrW(pszBuff, nBuffLength, L'=');		/* Marked = */
+			GetInt(pszBuff, nBuffLength);
+		}
+		if (version >= 5) {
+			layer = GetInt(pszBuff, nBuffLength);
+		}
+		hh1 = GetInt(pszBuff, nBuffLength, L':');
+		mm1 = GetInt(pszBuff, nBuffLength, L':');
+		ss1 = GetInt(pszBuff, nBuffLength, L'.');
+		ms1_div10 = GetInt(pszBuff, nBuffLength);
+		hh2 = GetInt(pszBuff, nBuffLength, L':');
+		mm2 = GetInt(pszBuff, nBuffLength, L':');
+		ss2 = GetInt(pszBuff, nBuffLength, L'.');
+		ms2_div10 = GetInt(pszBuff, nBuffLength);
+		CString Style = GetStrW(pszBuff, nBuffLength);
+		CString Actor = GetStrW(pszBuff, nBuffLength);
+		marginRect.left = GetInt(pszBuff, nBuffLength);
+		marginRect.right = GetInt(pszBuff, nBuffLength);
+		marginRect.top = marginRect.bottom = GetInt(pszBuff, nBuffLength);
+		if (version >= 6) {
+			marginRect.bottom = GetInt(pszBuff, nBuffLength);
+		}
+
+		CString Effect = GetStrW(pszBuff, nBuffLength);
+		int len = std::min(Effect.GetLength(), nBuffLength);
+		if (Effect.Left(len) == CString(pszBuff, len)) {
+			Effect.Empty();
+		}
+
+		Style.TrimLeft(L'*');
+		if (!Style.CompareNoCase(L"Default")) {
+			Style = L"Default";
+		}
+
+		dialogue.str        = pszBuff;
+		dialogue.start      = (((hh1*60 + mm1)*60) + ss1)*1000 + ms1_div10*10;
+		dialogue.end        = (((hh2*60 + mm2)*60) + ss2)*1000 + ms2_div10*10;
+		dialogue.style      = Style;
+		dialogue.actor      = Actor;
+		dialogue.effect     = Effect;
+		dialogue.marginRect = marginRect;
+		dialogue.layer      = layer;
+	} catch (...) {
+		return false;
+	}
+
+	return true;
+}
+
+// Parses the collected dialogue lines, on several threads for large scripts,
+// and adds them in the read order. Stops at the first invalid line like a serial parse.
+static bool AddSSADialogues(CTextFile* file, CSimpleTextSubtitle& ret, std::vector<SSADialogue>& dialogues, const int version)
+{
+	const size_t count = dialogues.size();
+	std::vector<BYTE> parsed(count);
+
+	size_t nThreads = 1;
+	if (count >= SSA_DIALOGUES_PARALLEL_MIN) {
+		nThreads = std::min<size_t>({ std::max(std::thread::hardware_concurrency(), 1u), 8, count / SSA_DIALOGUES_CHUNK });
+	}
+
+	if (nThreads > 1) {
+		std::atomic<size_t> nextChunk = 0;
+		auto worker = [&dialogues, &parsed, &nextChunk, count, version]() {
+			for (size_t start = nextChunk++ * SSA_DIALOGUES_CHUNK; start < count; start = nextChunk++ * SSA_DIALOGUES_CHUNK) {
+				const size_t end = std::min(start + SSA_DIALOGUES_CHUNK, count);
+				for (size_t i = start; i < end; i++) {
+					parsed[i] = ParseSSADialogue(dialogues[i], version);
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < nThreads; i++) {
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		auto& dialogue = dialogues[i];
+
+		if (nThreads <= 1) {
+			parsed[i] = ParseSSADialogue(dialogue, version);
+		}
+		if (!parsed[i]) {
+			file->Seek(dialogue.endPos, CFile::begin);
+			dialogues.clear();
+			return false;
+		}
+
+		ret.Add(dialogue.str, dialogue.start, dialogue.end, dialogue.style, dialogue.actor, dialogue.effect, dialogue.marginRect, dialogue.layer);
+	}
+
+	dialogues.clear();
+	return true;
+}
+
 static bool OpenSubStationAlpha(CTextFile* file, CSimpleTextSubtitle& ret)
 {
 	bool bRet = false;
@@ -1765,6 +2204,8 @@ static bool OpenSubStationAlpha(CTextFile* file, CSimpleTextSubtitle& ret)
 	int version = 3, sver = 3;
 	CStringW buff;
 
+	std::vector<SSADialogue> dialogues;
+
 	while (file->ReadString(buff)) {
 		FastTrim(buff);
 		if (buff.IsEmpty() || buff.GetAt(0) == L';') {
@@ -1778,56 +2219,23 @@ static bool OpenSubStationAlpha(CTextFile* file, CSimpleTextSubtitle& ret)
 
 		if (entry == L"dialogue") {
 			if (events) {
-				try {
-					int hh1, mm1, ss1, ms1_div10, hh2, mm2, ss2, ms2_div10, layer = 0;
-					CRect marginRect;
-
-					if (version <= 4) {
-						GetStrW(pszBuff, nBuffLength, L'=');		/* Marked = */
-						GetInt(pszBuff, nBuffLength);
-					}
-					if (version >= 5) {
-						layer = GetInt(pszBuff, nBuffLength);
-					}
-					hh1 = GetInt(pszBuff, nBuffLength, L':');
-					mm1 = GetInt(pszBuff, nBuffLength, L':');
-					ss1 = GetInt(pszBuff, nBuffLength, L'.');
-					ms1_div10 = GetInt(pszBuff, nBuffLength);
-					hh2 = GetInt(pszBuff, nBuffLength, L':');
-					mm2 = GetInt(pszBuff, nBuffLength, L':');
-					ss2 = GetInt(pszBuff, nBuffLength, L'.');
-					ms2_div10 = GetInt(pszBuff, nBuffLength);
-					CString Style = GetStrW(pszBuff, nBuffLength);
-					CString Actor = GetStrW(pszBuff, nBuffLength);
-					marginRect.left = GetInt(pszBuff, nBuffLength);
-					marginRect.right = GetInt(pszBuff, nBuffLength);
-					marginRect.top = marginRect.bottom = GetInt(pszBuff, nBuffLength);
-					if (version >= 6) {
-						marginRect.bottom = GetInt(pszBuff, nBuffLength);
-					}
-
-					CString Effect = GetStrW(pszBuff, nBuffLength);
-					int len = std::min(Effect.GetLength(), nBuffLength);
-					if (Effect.Left(len) == CString(pszBuff, len)) {
-						Effect.Empty();
-					}
-
-					Style.TrimLeft(L'*');
-					if (!Style.CompareNoCase(L"Default")) {
-						Style = L"Default";
-					}
+				auto& dialogue = dialogues.emplace_back();
+				dialogue.line = buff;
+				dialogue.endPos = file->GetPosition();
 
-					ret.Add(pszBuff,
-							(((hh1*60 + mm1)*60) + ss1)*1000 + ms1_div10*10,
-							(((hh2*60 + mm2)*60) + ss2)*1000 + ms2_div10*10,
-							Style, Actor, Effect,
-							marginRect,
-							layer);
-				} catch (...) {
+				if (dialogues.size() >= SSA_DIALOGUES_BATCH && !AddSSADialogues(file, ret, dialogues, version)) {
 					return false;
 				}
 			}
-		} else if (entry == L"style") {
+			continue;
+		}
+
+		// the collected dialogues are added before anything else is changed, comments are ignored anyway
+		if (entry != L"comment" && !dialogues.empty() && !AddSSADialogues(file, ret, dialogues, version)) {
+			return false;
+		}
+
+		if (entry == L"style") {
 			if (styles) {
 				STSStyle* style = DNew STSStyle;
 				if (!style) {
@@ -2003,6 +2411,10 @@ static bool OpenSubStationAlpha(CTextFile* file, CSimpleTextSubtitle& ret)
 		}
 	}
 
+	if (!dialogues.empty() && !AddSSADialogues(file, ret, dialogues, version)) {
+		return false;
+	}
+
 	return bRet;
 }
 
@@ -2148,11 +2560,15 @@ static bool OpenXombieSub(CTextFile* file, CSimpleTextSubtitle& ret)
 
 static bool OpenUSF(CTextFile* file, CSimpleTextSubtitle& ret)
 {
+	const ULONGLONG pos = file->GetPosition();
+
 	CString str;
 	while (file->ReadString(str)) {
 		if (str.Find(L"USFSubtitles") >= 0) {
+			file->Seek(pos, CFile::begin);
+
 			CUSFSubtitles usf;
-			if (usf.Read(file->GetFilePath()) && usf.ConvertToSTS(ret)) {
+			if (usf.Read(file) && usf.ConvertToSTS(ret)) {
 				return true;
 			}
 
@@ -2225,6 +2641,83 @@ const static OpenFunctStruct s_OpenFuncts[] = {
 	Subtitle::RT,   TIME,  OpenRealText,
 };
 
+// Reads the beginning of the file and returns the parsers whose signature was found there.
+// This only affects the order in which the parsers are tried, all others are still used as a fallback.
+
+#define SNIFF_MAX_LINES 32
+#define SNIFF_MAX_CHARS 4096
+
+static std::vector<STSOpenFunct> SniffOpenFuncts(CTextFile* file)
+{
+	std::vector<STSOpenFunct> likely;
+	auto add = [&likely](STSOpenFunct open) {
+		if (!Contains(likely, open)) {
+			likely.emplace_back(open);
+		}
+	};
+
+	CStringW buff;
+	int nLines = 0;
+	int nChars = 0;
+	while (nLines < SNIFF_MAX_LINES && nChars < SNIFF_MAX_CHARS && file->ReadString(buff)) {
+		nChars += buff.GetLength();
+		FastTrim(buff);
+		if (buff.IsEmpty()) {
+			continue;
+		}
+
+		if (nLines++ == 0 && StartsWith(buff, L"WEBVTT")) {
+			add(OpenVTT);
+			continue;
+		}
+
+		CStringW lower(buff);
+		lower.MakeLower();
+
+		if (StartsWith(lower, L"[script info]") || StartsWith(lower, L"[v4") || StartsWith(lower, L"scripttype:") || StartsWith(lower, L"dialogue:")) {
+			add(OpenSubStationAlpha);
+		} else if (buff.Find(L"-->") > 0) {
+			add(OpenSubRipper);
+		} else if (lower.Find(L"<tt ") >= 0 || lower.Find(L"<tt>") >= 0) {
+			add(OpenTTML);
+		} else if (lower.Find(L"<sami") >= 0) {
+			add(OpenSami);
+		} else if (buff.Find(L"USFSubtitles") >= 0) {
+			add(OpenUSF);
+		} else if (lower.Find(L"<window") >= 0) {
+			add(OpenRealText);
+		} else if (StartsWith(lower, L"[information]")) {
+			add(OpenSubViewer);
+		} else if (StartsWith(lower, L"screenhorizontal") || StartsWith(lower, L"screenvertical")) {
+			add(OpenXombieSub);
+		} else if (buff[0] == L'{') {
+			int v[6];
+			if (swscanf_s(buff, L"{%d:%d:%d}{%d:%d:%d}", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 6) {
+				add(OpenOldSubRipper);
+			} else if (swscanf_s(buff, L"{%d}{%d}", &v[0], &v[1]) == 2) {
+				add(OpenMicroDVD);
+			}
+		} else if (buff[0] == L'[') {
+			int v[2];
+			if (buff.GetLength() > 3 && iswdigit(buff[1]) && iswdigit(buff[2]) && buff[3] == L':') {
+				add(OpenLRC);
+			} else if (swscanf_s(buff, L"[%d][%d]", &v[0], &v[1]) == 2) {
+				add(OpenMPL2);
+			}
+		} else if (iswdigit(buff[0])) {
+			int v[8];
+			int n = 0;
+			if (swscanf_s(buff, L"%d:%d:%d.%d,%d:%d:%d.%d", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) == 8) {
+				add(OpenSubViewer);
+			} else if (swscanf_s(buff, L"%d:%d:%d:%n", &v[0], &v[1], &v[2], &n) == 3 && n > 0) {
+				add(OpenVPlayer);
+			}
+		}
+	}
+
+	return likely;
+}
+
 //
 
 CSimpleTextSubtitle::CSimpleTextSubtitle()
@@ -2399,7 +2892,7 @@ void CSimpleTextSubtitle::Add(CStringW str, int start, int end, CString style, C
 	// so that they are not lost when saving a subtitle file from MPC-BE
 	// and so that one can change the timings of such entries using the
 	// Subresync bar if necessary.
-	if (start == end) {
+	if (start == end || m_bDeferSegments) {
 		return;
 	}
 
@@ -3004,6 +3497,9 @@ void CSimpleTextSubtitle::CreateSegments()
 
 	for (size_t i = 0; i < GetCount(); i++) {
 		STSEntry& stse = GetAt(i);
+		if (stse.start == stse.end) {
+			continue; // never displayed, Add() skips these too
+		}
 		breakpoints.Add(Breakpoint(stse.start, true));
 		breakpoints.Add(Breakpoint(stse.end, false));
 	}
@@ -3044,6 +3540,16 @@ void CSimpleTextSubtitle::CreateSegments()
 	*/
 }
 
+void CSimpleTextSubtitle::SetDeferSegments(bool bDefer)
+{
+	if (m_bDeferSegments && !bDefer) {
+		m_bDeferSegments = false;
+		CreateSegments();
+	} else {
+		m_bDeferSegments = bDefer;
+	}
+}
+
 bool CSimpleTextSubtitle::Open(const CString& fn, UINT codePage, bool bAutoDetectCodePage, CString name, CString videoName)
 {
 	Empty();
@@ -3072,12 +3578,40 @@ static size_t CountLines(CTextFile* f, ULONGLONG from, ULONGLONG to, CString& s)
 
 bool CSimpleTextSubtitle::Open(CTextFile* f, const CString& name)
 {
+	const auto openStart = std::chrono::steady_clock::now();
+
 	Empty();
 
 	const UINT charSet = CodePageToCharSet(f->GetEncoding());
 	ULONGLONG pos = f->GetPosition();
 
+	// Updating the segments on every Add() is quadratic for heavily overlapping scripts,
+	// so build them once with a sweep over all entries after parsing
+	m_bDeferSegments = true;
+	struct CDeferSegmentsReset {
+		bool& bDefer;
+		~CDeferSegmentsReset() { bDefer = false; } // a parser may throw
+	} deferSegmentsReset = { m_bDeferSegments };
+
+	// try the parsers recognized by their signature first, most files are then opened by a single parser
+	const auto likely = SniffOpenFuncts(f);
+	f->Seek(pos, CFile::begin);
+
+	std::vector<const OpenFunctStruct*> openFuncts;
+	openFuncts.reserve(std::size(s_OpenFuncts));
 	for (const auto& OpenFunct : s_OpenFuncts) {
+		if (Contains(likely, OpenFunct.open)) {
+			openFuncts.emplace_back(&OpenFunct);
+		}
+	}
+	for (const auto& OpenFunct : s_OpenFuncts) {
+		if (!Contains(likely, OpenFunct.open)) {
+			openFuncts.emplace_back(&OpenFunct);
+		}
+	}
+
+	for (const auto pOpenFunct : openFuncts) {
+		const auto& OpenFunct = *pOpenFunct;
 		if (!OpenFunct.open(f, *this)) {
 			if (!IsEmpty()) {
 				CString lastLine;
@@ -3100,10 +3634,12 @@ bool CSimpleTextSubtitle::Open(CTextFile* f, const CString& name)
 		m_encoding     = f->GetEncoding();
 		m_path         = f->GetFilePath();
 
-		// No need to call Sort() or CreateSegments(), everything is done on the fly
+		// No need to call Sort(), the entries keep the read order
+		m_bDeferSegments = false;
+		CreateSegments();
 
 		CWebTextFile f2(CP_UTF8);
-		if (f2.Open(f->GetFilePath() + L".style")) {
+		if (!m_path.IsEmpty() && f2.Open(m_path + L".style")) {
 			OpenSubStationAlpha(&f2, *this);
 			f2.Close();
 		}
@@ -3116,6 +3652,12 @@ bool CSimpleTextSubtitle::Open(CTextFile* f, const CString& name)
 			m_dstScreenSize = DEFSCREENSIZE;
 		}
 
+		// the subtitles can be rendered once they are opened
+		DLog(L"CSimpleTextSubtitle::Open() : '%s' opened in %I64d ms, %Iu entries, %Iu segments",
+			 m_path.IsEmpty() ? name.GetString() : m_path.GetString(),
+			 (INT64)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - openStart).count(),
+			 GetCount(), m_segments.GetCount());
+
 		f->Close();
 		return true;
 	}
@@ -3126,36 +3668,14 @@ bool CSimpleTextSubtitle::Open(CTextFile* f, const CString& name)
 
 bool CSimpleTextSubtitle::Open(BYTE* data, int len, UINT codePage, CString name)
 {
-	WCHAR path[MAX_PATH];
-	if (!GetTempPathW(MAX_PATH, path)) {
-		return false;
-	}
-
-	WCHAR fn[MAX_PATH];
-	if (!GetTempFileNameW(path, L"vs", 0, fn)) {
-		return false;
-	}
+	Empty();
 
-	FILE* tmp = nullptr;
-	if (_wfopen_s(&tmp, fn, L"wb") || !tmp) {
+	CTextFile f(CP_UTF8, codePage, false);
+	if (len <= 0 || !f.Open(data, len)) {
 		return false;
 	}
 
-	int i = 0;
-	for (; i <= (len-1024); i += 1024) {
-		fwrite(&data[i], 1024, 1, tmp);
-	}
-	if (len > i) {
-		fwrite(&data[i], len - i, 1, tmp);
-	}
-
-	fclose(tmp);
-
-	bool fRet = Open(fn, codePage, false, name, {});
-
-	_wremove(fn);
-
-	return fRet;
+	return Open(&f, name);
 }
 
 bool CSimpleTextSubtitle::SaveAs(CString fn, Subtitle::SubType type, double fps, int delay, UINT e, bool bCreateExternalStyleFile)
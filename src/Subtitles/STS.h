@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -129,6 +129,7 @@ class CSimpleTextSubtitle : public CAtlArray<STSEntry>
 
 protected:
 	CAtlArray<STSSegment> m_segments;
+	bool m_bDeferSegments = false; // Add() doesn't update the segments, CreateSegments() must be called after adding
 	virtual void OnChanged() {}
 
 public:
@@ -169,6 +170,8 @@ public:
 
 	void Sort(bool fRestoreReadorder = false);
 	void CreateSegments();
+	// while enabled Add() doesn't update the segments, they are created once when it is disabled
+	void SetDeferSegments(bool bDefer);
 
 	void Append(CSimpleTextSubtitle& sts, int timeoff = -1);
 
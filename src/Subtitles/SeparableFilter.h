@@ -1,6 +1,6 @@
 /*
 * (C) 2007 Niels Martin Hansen
-* (C) 2013-2025 see Authors.txt
+* (C) 2013-2026 see Authors.txt
 *
 * This file is part of MPC-BE.
 *
@@ -23,6 +23,7 @@
 
 #define LIBDIVIDE_SSE2 1
 #include "libdivide.h"
+#include <thread>
 
 /*
 // Filter an image in horizontal direction with a one-dimensional filter
@@ -343,6 +344,9 @@ struct GaussianKernel {
 	int width;
 	int divisor;
 
+	std::vector<int> boxRadius;
+	std::vector<int> boxCoeff;
+
 	inline GaussianKernel(double sigma) {
 		width = (int)(sigma * 3.0 + 0.5) | 1; // binary-or with 1 to make sure the number is odd
 		if (width < 3) {
@@ -360,9 +364,205 @@ struct GaussianKernel {
 		if (divisor == 0) {
 			divisor = 1;
 		}
+
+		// split the kernel into boxes, from the widest to the narrowest
+		for (int d = width / 2; d >= 0; d--) {
+			const int outer = (d < width / 2) ? kernel[width / 2 + d + 1] : 0;
+			const int coeff = kernel[width / 2 + d] - outer;
+			if (coeff) {
+				boxRadius.push_back(d);
+				boxCoeff.push_back(coeff);
+			}
+		}
+	}
+
+	// prefix sums pay off when there are much fewer boxes than taps
+	inline bool UseBoxSums(bool bUseAVX2) const {
+		return (int)boxRadius.size() * (bUseAVX2 ? 4 : 8) < width;
 	}
 
 	inline ~GaussianKernel() {
 		delete [] kernel;
 	}
 };
+
+// Gaussian blur with prefix sums
+//
+// The integer kernel is symmetric, so it is split into a sum of centered boxes:
+// kernel[c + d] = sum of boxCoeff[i] over all boxes with boxRadius[i] >= d. Every box is one difference of a prefix sum, which
+// gives exactly the same integer sums as the direct convolution (zero outside the
+// image) at a cost that depends on the number of distinct taps, not on the radius.
+
+#define BOXSUM_MIN_THREAD_PIXELS (512 * 512) // per thread, starting the threads costs more than blurring smaller overlays
+#define BOXSUM_MAX_THREADS       8
+
+// acc[x] += coeff * (hi[x] - lo[x])
+static inline void BoxSumAccumulate(int* acc, const int* hi, const int* lo, int count, int coeff, bool bUseAVX2)
+{
+	int x = 0;
+	if (bUseAVX2) {
+		const __m256i vcoeff = _mm256_set1_epi32(coeff);
+		for (; x + 8 <= count; x += 8) {
+			__m256i diff = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)&hi[x]), _mm256_loadu_si256((const __m256i*)&lo[x]));
+			__m256i sum = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&acc[x]), _mm256_mullo_epi32(diff, vcoeff));
+			_mm256_storeu_si256((__m256i*)&acc[x], sum);
+		}
+	}
+	for (; x < count; x++) {
+		acc[x] += coeff * (hi[x] - lo[x]);
+	}
+}
+
+// out[x] = clamp(acc[x] / divisor), acc must be 16-byte aligned
+static inline void BoxSumStore(const int* acc, unsigned char* out, int width, const libdivide::divider<int>& divisorLibdivide, int divisor)
+{
+	const int width16 = width & ~15;
+	for (int x = 0; x < width16; x += 16) {
+		__m128i accum1 = _mm_load_si128((const __m128i*)&acc[x]) / divisorLibdivide;
+		__m128i accum2 = _mm_load_si128((const __m128i*)&acc[x + 4]) / divisorLibdivide;
+		accum1 = _mm_packs_epi32(accum1, accum2);
+		__m128i accum3 = _mm_load_si128((const __m128i*)&acc[x + 8]) / divisorLibdivide;
+		__m128i accum4 = _mm_load_si128((const __m128i*)&acc[x + 12]) / divisorLibdivide;
+		accum3 = _mm_packs_epi32(accum3, accum4);
+		_mm_storeu_si128((__m128i*)&out[x], _mm_packus_epi16(accum1, accum3));
+	}
+	for (int x = width16; x < width; x++) {
+		int accum = acc[x] / divisor;
+		if (accum > 255) {
+			accum = 255;
+		} else if (accum < 0) {
+			accum = 0;
+		}
+		out[x] = (unsigned char)accum;
+	}
+}
+
+static inline int BoxSumThreads(int width, int height)
+{
+	const int nThreads = (int)std::min<size_t>((size_t)width * height / BOXSUM_MIN_THREAD_PIXELS, BOXSUM_MAX_THREADS);
+	return std::clamp(std::min(nThreads, (int)std::thread::hardware_concurrency()), 1, std::max(height, 1));
+}
+
+// Runs fn(i, yStart, yEnd) on nThreads row ranges, i is the index of the range
+template<typename F>
+static void BoxSumForRows(int height, int nThreads, F fn)
+{
+	if (nThreads <= 1) {
+		fn(0, 0, height);
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	threads.reserve(nThreads - 1);
+	for (int i = 1; i < nThreads; i++) {
+		threads.emplace_back(fn, i, height * i / nThreads, height * (i + 1) / nThreads);
+	}
+	fn(0, 0, height / nThreads);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+// Filter an image in horizontal direction with the box decomposition of a kernel,
+// returns false without touching dst if the buffers can't be allocated
+static bool BoxSumFilterX(const unsigned char* src, unsigned char* dst, int width, int height, ptrdiff_t stride,
+						  const std::vector<int>& boxRadius, const std::vector<int>& boxCoeff, int divisor, bool bUseAVX2)
+{
+	// per thread: the row prefix sums followed by the accumulators
+	const int nThreads = BoxSumThreads(width, height);
+	const size_t scratchSize = ((width + 1 + 3) & ~3) + ((width + 3) & ~3); // keeps every part 16-byte aligned
+	int* scratch = (int*)_aligned_malloc(nThreads * scratchSize * sizeof(int), 16);
+	if (!scratch) {
+		return false;
+	}
+
+	const libdivide::divider<int> divisorLibdivide(divisor);
+
+	BoxSumForRows(height, nThreads, [&](int i, int yStart, int yEnd) {
+		int* prefix = scratch + i * scratchSize;
+		int* acc = prefix + ((width + 1 + 3) & ~3);
+
+		for (int y = yStart; y < yEnd; y++) {
+			const unsigned char* in = src + y * stride;
+			unsigned char* out = dst + y * stride;
+
+			prefix[0] = 0;
+			for (int x = 0; x < width; x++) {
+				prefix[x + 1] = prefix[x] + in[x];
+			}
+			ZeroMemory(acc, width * sizeof(int));
+
+			for (size_t i = 0; i < boxRadius.size(); i++) {
+				const int r = boxRadius[i];
+				const int c = boxCoeff[i];
+
+				// the box [x - r, x + r] is completely inside the row for x in [r, width - r)
+				int xMid0 = std::min(r, width);
+				int xMid1 = std::max(width - r, xMid0);
+				for (int x = 0; x < xMid0; x++) {
+					acc[x] += c * (prefix[std::min(x + r + 1, width)] - prefix[std::max(x - r, 0)]);
+				}
+				if (xMid1 > xMid0) {
+					BoxSumAccumulate(acc + xMid0, prefix + xMid0 + r + 1, prefix + xMid0 - r, xMid1 - xMid0, c, bUseAVX2);
+				}
+				for (int x = xMid1; x < width; x++) {
+					acc[x] += c * (prefix[std::min(x + r + 1, width)] - prefix[std::max(x - r, 0)]);
+				}
+			}
+
+			BoxSumStore(acc, out, width, divisorLibdivide, divisor);
+		}
+	});
+
+	_aligned_free(scratch);
+	return true;
+}
+
+// Filter an image in vertical direction with the box decomposition of a kernel,
+// returns false without touching dst if the buffers can't be allocated
+static bool BoxSumFilterY(const unsigned char* src, unsigned char* dst, int width, int height, ptrdiff_t stride,
+						  const std::vector<int>& boxRadius, const std::vector<int>& boxCoeff, int divisor, bool bUseAVX2)
+{
+	const int nThreads = BoxSumThreads(width, height);
+	const size_t accSize = (width + 3) & ~3;
+
+	// column prefix sums, row y holds the sums of the source rows [0, y)
+	int* prefix = (int*)_aligned_malloc((height + 1) * stride * sizeof(int), 16);
+	int* accs = (int*)_aligned_malloc(nThreads * accSize * sizeof(int), 16);
+	if (!prefix || !accs) {
+		_aligned_free(prefix);
+		_aligned_free(accs);
+		return false;
+	}
+	ZeroMemory(prefix, width * sizeof(int));
+	for (int y = 0; y < height; y++) {
+		const unsigned char* in = src + y * stride;
+		const int* prev = prefix + y * stride;
+		int* cur = prefix + (y + 1) * stride;
+		for (int x = 0; x < width; x++) {
+			cur[x] = prev[x] + in[x];
+		}
+	}
+
+	const libdivide::divider<int> divisorLibdivide(divisor);
+
+	BoxSumForRows(height, nThreads, [&](int i, int yStart, int yEnd) {
+		int* acc = accs + i * accSize;
+
+		for (int y = yStart; y < yEnd; y++) {
+			ZeroMemory(acc, width * sizeof(int));
+
+			for (size_t i = 0; i < boxRadius.size(); i++) {
+				const int* hi = prefix + std::min(y + boxRadius[i] + 1, height) * stride;
+				const int* lo = prefix + std::max(y - boxRadius[i], 0) * stride;
+				BoxSumAccumulate(acc, hi, lo, width, boxCoeff[i], bUseAVX2);
+			}
+
+			BoxSumStore(acc, dst + y * stride, width, divisorLibdivide, divisor);
+		}
+	});
+
+	_aligned_free(accs);
+	_aligned_free(prefix);
+	return true;
+}
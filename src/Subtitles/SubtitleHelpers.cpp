@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2023 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -21,12 +21,179 @@
 
 #include "stdafx.h"
 #include <io.h>
-#include <regex>
+#include <mutex>
 #include "TextFile.h"
 #include "SubtitleHelpers.h"
 #include "DSUtil/Filehandle.h"
 
-static LPCWSTR extListVid = L"(avi)|(mkv)|(mp4)|((m2)?ts)";
+static const LPCWSTR s_VidFileExts[] = {
+	L"avi", L"mkv", L"mp4", L"ts", L"m2ts"
+};
+
+static bool IsSubFileExt(LPCWSTR ext)
+{
+	return std::any_of(std::cbegin(Subtitle::s_SubFileExts), std::cend(Subtitle::s_SubFileExts), [&](LPCWSTR subExt) {
+		return _wcsicmp(ext, subExt) == 0;
+	});
+}
+
+static bool IsVidFileExt(LPCWSTR ext)
+{
+	return std::any_of(std::cbegin(s_VidFileExts), std::cend(s_VidFileExts), [&](LPCWSTR vidExt) {
+		return _wcsicmp(ext, vidExt) == 0;
+	});
+}
+
+// matches "[.suffix].ext" after the title
+static bool MatchSubFileSuffix(LPCWSTR suffix)
+{
+	if (suffix[0] != L'.') {
+		return false;
+	}
+
+	LPCWSTR ext = wcsrchr(suffix, L'.');
+	if (ext != suffix && ext - suffix < 2) { // the optional suffix is a dot followed by one or more characters
+		return false;
+	}
+
+	return IsSubFileExt(ext + 1);
+}
+
+// matches "name.ext" after the title
+static bool MatchVidFileSuffix(LPCWSTR suffix)
+{
+	LPCWSTR ext = wcsrchr(suffix, L'.');
+	return ext && ext != suffix && IsVidFileExt(ext + 1);
+}
+
+//
+// CDirectoryListCache
+//
+
+// Keeps the listings of the recently searched directories, a listing is reused
+// while the modification time of the directory is unchanged. Some file systems
+// (FAT, some network shares) do not update it reliably, so listings also expire.
+// A local directory is listed once and reused for every title in it. On network
+// paths only the names starting with the title are listed, so that the server
+// filters large shared folders.
+
+class CDirectoryListCache
+{
+public:
+	struct Entry {
+		CString name;
+		bool    bDirectory;
+	};
+	using Listing = std::shared_ptr<const std::vector<Entry>>;
+
+private:
+	static constexpr size_t    MaxDirs = 16;
+	static constexpr ULONGLONG MaxAge  = 30000; // ms
+
+	struct Dir {
+		CString   path;
+		FILETIME  mtime;
+		ULONGLONG tick;
+		Listing   listing;
+	};
+
+	std::mutex     m_mutex;
+	std::list<Dir> m_dirs; // most recently used first
+
+	size_t m_nLookups = 0;
+	size_t m_nHits    = 0;
+
+	// m_mutex must be locked
+	void CountLookup(bool bHit)
+	{
+		m_nLookups++;
+		if (bHit) {
+			m_nHits++;
+		}
+		DLogIf(m_nLookups % 64 == 0, L"CDirectoryListCache : %Iu directory lookups, %Iu served from the cache", m_nLookups, m_nHits);
+	}
+
+	static Listing ReadDirectory(const CString& path, const CString& prefix)
+	{
+		auto listing = std::make_shared<std::vector<Entry>>();
+
+		WIN32_FIND_DATAW wfd;
+		HANDLE hFile = FindFirstFileExW(path + prefix + L"*", FindExInfoBasic, &wfd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+		if (hFile != INVALID_HANDLE_VALUE) {
+			do {
+				listing->push_back({ wfd.cFileName, !!(wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) });
+			} while (FindNextFileW(hFile, &wfd));
+
+			FindClose(hFile);
+		}
+
+		return listing;
+	}
+
+public:
+	// path must end with a backslash, the listing may be limited to the names starting with prefix
+	Listing GetListing(const CString& path, const CString& prefix)
+	{
+		const CString filter = ::PathIsNetworkPathW(path) ? prefix : CString();
+
+		CString dir(path);
+		if (dir.GetLength() > 3) {
+			dir.TrimRight(L'\\');
+		}
+
+		WIN32_FILE_ATTRIBUTE_DATA fad;
+		if (!GetFileAttributesExW(dir, GetFileExInfoStandard, &fad)) {
+			// not a directory we can check, list it without caching
+			std::unique_lock<std::mutex> lock(m_mutex);
+			CountLookup(false);
+			lock.unlock();
+			return ReadDirectory(path, filter);
+		}
+		if (!(fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			return nullptr;
+		}
+
+		const CString key = CString(path + filter).MakeUpper();
+		const ULONGLONG tick = GetTickCount64();
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			for (auto it = m_dirs.begin(); it != m_dirs.end(); ++it) {
+				if (it->path == key) {
+					if (CompareFileTime(&it->mtime, &fad.ftLastWriteTime) == 0 && tick - it->tick < MaxAge) {
+						CountLookup(true);
+						m_dirs.splice(m_dirs.begin(), m_dirs, it);
+						return it->listing;
+					}
+					m_dirs.erase(it);
+					break;
+				}
+			}
+
+			CountLookup(false);
+		}
+
+		Listing listing = ReadDirectory(path, filter);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		// another thread may have listed the same directory in the meantime
+		for (auto it = m_dirs.begin(); it != m_dirs.end(); ++it) {
+			if (it->path == key) {
+				m_dirs.erase(it);
+				break;
+			}
+		}
+		m_dirs.push_front({ key, fad.ftLastWriteTime, tick, listing });
+		if (m_dirs.size() > MaxDirs) {
+			m_dirs.pop_back();
+		}
+
+		return listing;
+	}
+};
+
+static CDirectoryListCache s_DirectoryListCache;
 
 LPCWSTR Subtitle::GetSubtitleFileExt(SubType type)
 {
@@ -59,21 +226,6 @@ void Subtitle::GetSubFileNames(CString fn, const std::vector<CString>& paths, st
 	int titleLength = title.GetLength();
 
 	if (!fWeb) {
-		WIN32_FIND_DATA wfd;
-
-		CString extListSub, regExpSub, regExpVid;
-
-		for (const auto& subext : s_SubFileExts) {
-			extListSub.AppendFormat(L"(%s)|", subext);
-		}
-		extListSub.TrimRight('|');
-
-		regExpSub.Format(L"(\\..+)?\\.(%s)$", extListSub); // [.suffix].ext
-		regExpVid.Format(L".+\\.(%s)$", extListVid);
-
-		const std::wregex::flag_type reFlags = std::wregex::icase | std::wregex::optimize;
-		std::wregex reSub(regExpSub, reFlags), reVid(regExpVid, reFlags);
-
 		for (size_t k = 0; k < paths.size(); k++) {
 			CString path = paths[k];
 			path.Replace(L'\\', L'/');
@@ -90,21 +242,26 @@ void Subtitle::GetSubFileNames(CString fn, const std::vector<CString>& paths, st
 			path.Replace(L"/./", L"/");
 			path.Replace(L'/', L'\\');
 
+			const auto listing = s_DirectoryListCache.GetListing(path, title);
+			if (!listing) {
+				continue;
+			}
+
 			std::list<CString> subs, vids;
 
-			HANDLE hFile = FindFirstFileW(path + title + L"*", &wfd);
-			if (hFile != INVALID_HANDLE_VALUE) {
-				do {
-					CString fname = path + wfd.cFileName;
-					if (std::regex_match(&wfd.cFileName[titleLength], reSub)) {
-						subs.push_back(fname);
-					} else if (std::regex_match(&wfd.cFileName[titleLength], reVid)) {
-						// Convert to lower-case and cut the extension for easier matching
-						vids.push_back(fname.Left(fname.ReverseFind('.')).MakeLower());
-					}
-				} while (FindNextFileW(hFile, &wfd));
+			for (const auto& entry : *listing) {
+				if (entry.name.GetLength() < titleLength || _wcsnicmp(entry.name, title, titleLength) != 0) {
+					continue;
+				}
 
-				FindClose(hFile);
+				LPCWSTR suffix = entry.name.GetString() + titleLength;
+				CString fname = path + entry.name;
+				if (MatchSubFileSuffix(suffix)) {
+					subs.push_back(fname);
+				} else if (MatchVidFileSuffix(suffix)) {
+					// Convert to lower-case and cut the extension for easier matching
+					vids.push_back(fname.Left(fname.ReverseFind('.')).MakeLower());
+				}
 			}
 
 			for (const auto& sub : subs) {
@@ -128,22 +285,18 @@ void Subtitle::GetSubFileNames(CString fn, const std::vector<CString>& paths, st
 
 		// // Load all subs from folder .\Subs\FILENAME_WITHOUT_EXT
 		CString path = orgpath + L"Subs\\" + title + L"\\";
-		HANDLE hFile = FindFirstFileW(path + L"*", &wfd);
-		if (hFile != INVALID_HANDLE_VALUE) {
-			do {
-				if (!(wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-					CString fname = path + wfd.cFileName;
-					const CString ext = GetFileExt(wfd.cFileName).Mid(1).MakeLower();
-					const bool validate_ext = std::any_of(std::cbegin(s_SubFileExts), std::cend(s_SubFileExts), [&](LPCWSTR subExt) {
-						return ext == subExt;
-					});
-					if (validate_ext) {
-						ret.push_back(fname);
+		path.Replace(L'/', L'\\');
+		if (const auto listing = s_DirectoryListCache.GetListing(path, L"")) {
+			for (const auto& entry : *listing) {
+				if (!entry.bDirectory) {
+					LPCWSTR ext = wcsrchr(entry.name, L'.');
+					if (ext && IsSubFileExt(ext + 1)) {
+						ret.push_back(path + entry.name);
 					}
 				}
-			} while (FindNextFileW(hFile, &wfd));
-			FindClose(hFile);
+			}
 		}
+
 	} else if (l > 7) {
 		CWebTextFile wtf; // :)
 		if (wtf.Open(orgpath + title + L".wse")) {
@@ -161,6 +314,11 @@ void Subtitle::GetSubFileNames(CString fn, const std::vector<CString>& paths, st
 	});
 }
 
+static inline bool IsNameSeparator(const WCHAR c)
+{
+	return c == L'.' || c == L'-' || c == L'_' || c == L' ';
+}
+
 CString Subtitle::GuessSubtitleName(CString fn, CString videoName)
 {
 	CString name, lang;
@@ -195,32 +353,59 @@ CString Subtitle::GuessSubtitleName(CString fn, CString videoName)
 			}
 			subName = subName.Mid(iVideoNameEnd);
 
-			std::wregex re(L"^[.\\-_ ]+([^.\\-_ ]+)(?:[.\\-_ ]+([^.\\-_ ]+))?", std::wregex::icase);
-			std::wcmatch mc;
-			if (std::regex_search((LPCWSTR)subName, mc, re)) {
-				ASSERT(mc.size() == 3);
-				ASSERT(mc[1].matched);
-				lang = ISO639XToLanguage(CStringA(mc[1].str().c_str()), true);
+			// "<separators><language>[<separators><hi>]" right after the video name
+			const int len = subName.GetLength();
+			int b1 = 0;
+			while (b1 < len && IsNameSeparator(subName[b1])) {
+				b1++;
+			}
+			if (b1 > 0 && b1 < len) {
+				int e1 = b1;
+				while (e1 < len && !IsNameSeparator(subName[e1])) {
+					e1++;
+				}
+				lang = ISO639XToLanguage(CStringA(subName.Mid(b1, e1 - b1)), true);
 
-				if (!lang.IsEmpty() && mc[2].matched) {
-					bHearingImpaired = (CString(mc[2].str().c_str()).CompareNoCase(L"hi") == 0);
+				int b2 = e1;
+				while (b2 < len && IsNameSeparator(subName[b2])) {
+					b2++;
+				}
+				if (!lang.IsEmpty() && b2 > e1 && b2 < len) {
+					int e2 = b2;
+					while (e2 < len && !IsNameSeparator(subName[e2])) {
+						e2++;
+					}
+					bHearingImpaired = (subName.Mid(b2, e2 - b2).CompareNoCase(L"hi") == 0);
 				}
 			}
 		}
 	}
 
 	// If we couldn't find any info yet, we try to find the language at the end of the filename
-	if (lang.IsEmpty()) {
-		std::wregex re(L".*?[.\\-_ ]+([^.\\-_ ]+)(?:[.\\-_ ]+([^.\\-_ ]+))?$", std::wregex::icase);
-		std::wcmatch mc;
-		if (std::regex_search((LPCWSTR)subName, mc, re)) {
-			ASSERT(mc.size() == 3);
-			ASSERT(mc[1].matched);
-			lang = ISO639XToLanguage(CStringA(mc[1].str().c_str()), true);
+	// "<separators><language>[<separators><hi>]" at the end, both tokens must follow a separator
+	const int len = subName.GetLength();
+	if (lang.IsEmpty() && len > 0 && !IsNameSeparator(subName[len - 1])) {
+		int b2 = len;
+		while (b2 > 0 && !IsNameSeparator(subName[b2 - 1])) {
+			b2--;
+		}
+		int e1 = b2;
+		while (e1 > 0 && IsNameSeparator(subName[e1 - 1])) {
+			e1--;
+		}
+		int b1 = e1;
+		while (b1 > 0 && !IsNameSeparator(subName[b1 - 1])) {
+			b1--;
+		}
 
+		if (b2 > 0) {
 			CStringA str;
-			if (mc[2].matched) {
-				str = mc[2].str().c_str();
+			if (b1 > 0 && b1 < e1) {
+				lang = ISO639XToLanguage(CStringA(subName.Mid(b1, e1 - b1)), true);
+				str = subName.Mid(b2);
+			} else {
+				// only one token after a separator
+				lang = ISO639XToLanguage(CStringA(subName.Mid(b2)), true);
 			}
 
 			if (!lang.IsEmpty() && str.CompareNoCase("hi") == 0) {
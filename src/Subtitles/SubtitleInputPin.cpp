@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -57,6 +57,23 @@ static const bool IsHdmvSub(const CMediaType* pmt)
 			: false;
 }
 
+// FNV-1a of the sample times and data
+static ULONGLONG TextEventKey(const BYTE* pData, const size_t nLen, const REFERENCE_TIME tStart, const REFERENCE_TIME tStop)
+{
+	ULONGLONG hash = 14695981039346656037ULL;
+	auto add = [&hash](const BYTE* p, const size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			hash = (hash ^ p[i]) * 1099511628211ULL;
+		}
+	};
+
+	add((const BYTE*)&tStart, sizeof(tStart));
+	add((const BYTE*)&tStop, sizeof(tStop));
+	add(pData, nLen);
+
+	return hash;
+}
+
 CSubtitleInputPin::CSubtitleInputPin(CBaseFilter* pFilter, CCritSec* pLock, CCritSec* pSubLock, HRESULT* phr)
 	: CBaseInputPin(L"CSubtitleInputPin", pFilter, pLock, phr, L"Input")
 	, m_pSubLock(pSubLock)
@@ -98,6 +115,11 @@ HRESULT CSubtitleInputPin::CompleteConnect(IPin* pReceivePin)
 {
 	InvalidateSamples();
 
+	{
+		CAutoLock cAutoLock(m_pSubLock);
+		m_textEventKeys.clear();
+	}
+
 	if (m_mt.majortype == MEDIATYPE_Text) {
 		if (!(m_pSubStream = DNew CRenderedTextSubtitle(m_pSubLock))) {
 			return E_FAIL;
@@ -249,22 +271,15 @@ STDMETHODIMP CSubtitleInputPin::NewSegment(REFERENCE_TIME tStart, REFERENCE_TIME
 
 	InvalidateSamples();
 
-	if (m_mt.majortype == MEDIATYPE_Text
-			|| (m_mt.majortype == MEDIATYPE_Subtitle
-			&& (m_mt.subtype == MEDIASUBTYPE_UTF8
-				/*|| m_mt.subtype == MEDIASUBTYPE_USF*/
-				|| m_mt.subtype == MEDIASUBTYPE_SSA
-				|| m_mt.subtype == MEDIASUBTYPE_ASS
-				|| m_mt.subtype == MEDIASUBTYPE_ASS2
-				|| m_mt.subtype == MEDIASUBTYPE_WEBVTT))) {
+	if (m_mt.majortype == MEDIATYPE_Text) {
 		CAutoLock cAutoLock2(m_pSubLock);
 		CRenderedTextSubtitle* pRTS = (CRenderedTextSubtitle*)m_pSubStream.p;
-		if (pRTS->m_webvtt_allow_clear || pRTS->m_subtitleType != Subtitle::VTT) {
-			pRTS->RemoveAll();
-			pRTS->CreateSegments();
-		}
-		// WebVTT can be read as one big blob of data during pin connection, instead of as samples during playback.
-		// This depends on how it is being demuxed. So clear only if we previously got data through samples.
+		pRTS->RemoveAll();
+		pRTS->CreateSegments();
+	} else if (IsTextSub()) {
+		// The sample times are absolute, so the events received before the seek stay valid.
+		// The events delivered again are skipped in DecodeSample() and WebVTT read as one
+		// blob of data during pin connection is kept as well.
 	} else if ((m_mt.majortype == MEDIATYPE_Subtitle && m_mt.subtype == MEDIASUBTYPE_VOBSUB)
 				|| (m_mt.majortype == MEDIATYPE_Video && m_mt.subtype == MEDIASUBTYPE_DVD_SUBPICTURE)) {
 		CAutoLock cAutoLock2(m_pSubLock);
@@ -373,6 +388,18 @@ void  CSubtitleInputPin::DecodeSamples()
 			CAutoLock cAutoLock(m_pSubLock);
 			lock.lock(); // Reacquire the lock
 
+			// Adding a large batch of text events at once is cheaper with a single rebuild of the segments,
+			// the segments are otherwise split for every event
+			CRenderedTextSubtitle* pRTS = nullptr;
+			if (IsTextSub() && m_sampleQueue.size() >= 64) {
+				pRTS = (CRenderedTextSubtitle*)m_pSubStream.p;
+				if (m_sampleQueue.size() * 4 >= pRTS->GetCount()) {
+					pRTS->SetDeferSegments(true);
+				} else {
+					pRTS = nullptr;
+				}
+			}
+
 			while (!m_sampleQueue.empty() && !needStopProcessing()) {
 				const auto& pSample = m_sampleQueue.front();
 
@@ -390,6 +417,10 @@ void  CSubtitleInputPin::DecodeSamples()
 
 				m_sampleQueue.pop_front();
 			}
+
+			if (pRTS) {
+				pRTS->SetDeferSegments(false);
+			}
 		}
 
 		if (rtInvalidate >= 0) {
@@ -480,18 +511,29 @@ REFERENCE_TIME CSubtitleInputPin::DecodeSample(const std::unique_ptr<SubtitleSam
 		if (m_mt.subtype == MEDIASUBTYPE_UTF8 || m_mt.subtype == MEDIASUBTYPE_WEBVTT) {
 			CRenderedTextSubtitle* pRTS = (CRenderedTextSubtitle*)m_pSubStream.p;
 
+			const ULONGLONG key = TextEventKey(pData, nLen, tStart, tStop);
+			if (!IsNewTextEvent(pRTS, key)) {
+				return -1;
+			}
+
 			CStringW str = UTF8ToWStr(CStringA((LPCSTR)pData, nLen));
 			FastTrim(str);
 			if (!str.IsEmpty()) {
+				const size_t count = pRTS->GetCount();
 				pRTS->Add(str, (int)(tStart / 10000), (int)(tStop / 10000));
-				bInvalidate = true;
-				if (pRTS->m_subtitleType == Subtitle::VTT) {
-					pRTS->m_webvtt_allow_clear = true;
+				if (pRTS->GetCount() > count) {
+					m_textEventKeys.emplace(key);
 				}
+				bInvalidate = true;
 			}
 		} else if (m_mt.subtype == MEDIASUBTYPE_SSA || m_mt.subtype == MEDIASUBTYPE_ASS || m_mt.subtype == MEDIASUBTYPE_ASS2) {
 			CRenderedTextSubtitle* pRTS = (CRenderedTextSubtitle*)m_pSubStream.p;
 
+			const ULONGLONG key = TextEventKey(pData, nLen, tStart, tStop);
+			if (!IsNewTextEvent(pRTS, key)) {
+				return -1;
+			}
+
 			CStringW str = UTF8ToWStr(CStringA((LPCSTR)pData, nLen)).Trim();
 			if (!str.IsEmpty()) {
 				STSEntry stse;
@@ -518,8 +560,12 @@ REFERENCE_TIME CSubtitleInputPin::DecodeSample(const std::unique_ptr<SubtitleSam
 				}
 
 				if (!stse.str.IsEmpty()) {
+					const size_t count = pRTS->GetCount();
 					pRTS->Add(stse.str, (int)(tStart / 10000), (int)(tStop / 10000),
 							  stse.style, stse.actor, stse.effect, stse.marginRect, stse.layer, stse.readorder);
+					if (pRTS->GetCount() > count) {
+						m_textEventKeys.emplace(key);
+					}
 					bInvalidate = true;
 				}
 			}
@@ -539,6 +585,26 @@ REFERENCE_TIME CSubtitleInputPin::DecodeSample(const std::unique_ptr<SubtitleSam
 	return bInvalidate ? tStart : -1;
 }
 
+bool CSubtitleInputPin::IsTextSub() const
+{
+	return m_mt.majortype == MEDIATYPE_Subtitle
+		&& (m_mt.subtype == MEDIASUBTYPE_UTF8
+			|| m_mt.subtype == MEDIASUBTYPE_SSA
+			|| m_mt.subtype == MEDIASUBTYPE_ASS
+			|| m_mt.subtype == MEDIASUBTYPE_ASS2
+			|| m_mt.subtype == MEDIASUBTYPE_WEBVTT);
+}
+
+bool CSubtitleInputPin::IsNewTextEvent(const CSimpleTextSubtitle* pSTS, ULONGLONG key)
+{
+	// every key belongs to an entry, fewer entries means that the subtitle was cleared
+	if (m_textEventKeys.size() > pSTS->GetCount()) {
+		m_textEventKeys.clear();
+	}
+
+	return m_textEventKeys.find(key) == m_textEventKeys.end();
+}
+
 void CSubtitleInputPin::InvalidateSamples()
 {
 	m_bStopDecoding = true;
@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2021 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -23,9 +23,12 @@
 
 #include <thread>
 #include <condition_variable>
+#include <unordered_set>
 
 #include "SubPic/ISubPic.h"
 
+class CSimpleTextSubtitle;
+
 //
 // CSubtitleInputPin
 //
@@ -54,6 +57,12 @@ class CSubtitleInputPin : public CBaseInputPin
 	std::mutex m_mutexQueue; // to protect m_sampleQueue
 	std::condition_variable m_condQueueReady;
 
+	// keys of the text events added from samples, the events delivered again after a seek are skipped
+	std::unordered_set<ULONGLONG> m_textEventKeys;
+
+	bool IsTextSub() const;
+	bool IsNewTextEvent(const CSimpleTextSubtitle* pSTS, ULONGLONG key);
+
 	void DecodeSamples();
 	REFERENCE_TIME DecodeSample(const std::unique_ptr<SubtitleSample>& pSample);
 	void InvalidateSamples();
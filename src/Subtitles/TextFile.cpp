@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -21,6 +21,8 @@
 
 #include "stdafx.h"
 #include <afxinet.h>
+#include <intrin.h>
+#include <emmintrin.h>
 #include "TextFile.h"
 #include <Utf8.h>
 #include "DSUtil/FileHandle.h"
@@ -50,6 +52,78 @@ const static struct {
 
 #define TEXTFILE_BUFFER_SIZE (64 * 1024)
 
+// Returns the number of leading ASCII bytes before the first line end or non-ASCII byte.
+static int AsciiRunLength(const char* src, const int len)
+{
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+
+	int n = 0;
+	for (; n + 16 <= len; n += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i*)&src[n]);
+		const __m128i eol = _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr));
+		const int mask = _mm_movemask_epi8(_mm_or_si128(v, eol));
+		if (mask) {
+			unsigned long idx;
+			_BitScanForward(&idx, mask);
+			return n + idx;
+		}
+	}
+	for (; n < len; n++) {
+		if ((src[n] & 0x80) || src[n] == '\n' || src[n] == '\r') {
+			break;
+		}
+	}
+
+	return n;
+}
+
+// Returns the length of the line before the first line end, bAscii is cleared if it has non-ASCII bytes.
+static int FindLineEnd(const char* src, const int len, bool& bAscii)
+{
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+
+	int nonAscii = 0;
+	int n = 0;
+	for (; n + 16 <= len; n += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i*)&src[n]);
+		const int eol = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+		const int high = _mm_movemask_epi8(v);
+		if (eol) {
+			unsigned long idx;
+			_BitScanForward(&idx, eol);
+			bAscii = !(nonAscii | (high & ((1 << idx) - 1)));
+			return n + idx;
+		}
+		nonAscii |= high;
+	}
+	for (; n < len; n++) {
+		if (src[n] == '\n' || src[n] == '\r') {
+			break;
+		}
+		nonAscii |= src[n] & 0x80;
+	}
+	bAscii = !nonAscii;
+
+	return n;
+}
+
+static void WidenAscii(const char* src, const int len, WCHAR* dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	int n = 0;
+	for (; n + 16 <= len; n += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i*)&src[n]);
+		_mm_storeu_si128((__m128i*)&dst[n], _mm_unpacklo_epi8(v, zero));
+		_mm_storeu_si128((__m128i*)&dst[n + 8], _mm_unpackhi_epi8(v, zero));
+	}
+	for (; n < len; n++) {
+		dst[n] = (WCHAR)src[n];
+	}
+}
+
 CTextFile::CTextFile(UINT encoding/* = ASCII*/, UINT defaultencoding/* = ASCII*/, bool bAutoDetectCodePage/* = false*/)
 	: m_encoding(encoding)
 	, m_defaultencoding(defaultencoding)
@@ -88,12 +162,33 @@ bool CTextFile::Open(LPCWSTR lpszFileName)
 		return false;
 	}
 
+	return OpenSource();
+}
+
+bool CTextFile::Open(const BYTE* data, size_t size)
+{
+	Close();
+
+	if (!data || size > UINT_MAX) {
+		return false;
+	}
+
+	// nGrowBytes = 0 makes the attached buffer read-only and it is not freed by CMemFile
+	m_pMemFile = std::make_unique<CMemFile>(const_cast<BYTE*>(data), (UINT)size, 0);
+
+	return OpenSource();
+}
+
+bool CTextFile::OpenSource()
+{
+	CFile* pFile = GetSource();
+
 	m_offset = 0;
 	m_nInBuffer = m_posInBuffer = 0;
 
-	if (m_pStdioFile->GetLength() >= 4) {
+	if (pFile->GetLength() >= 4) {
 		uint8_t b[4] = {};
-		if (sizeof(b) != m_pStdioFile->Read(b, sizeof(b))) {
+		if (sizeof(b) != pFile->Read(b, sizeof(b))) {
 			Close();
 			return false;
 		}
@@ -153,14 +248,29 @@ bool CTextFile::Open(LPCWSTR lpszFileName)
 		}
 	} else {
 		Seek(0, CStdioFile::begin);
-		m_posInFile = m_pStdioFile->GetPosition();
+		m_posInFile = pFile->GetPosition();
 	}
 
 	return true;
 }
 
+CFile* CTextFile::GetSource() const
+{
+	if (m_pMemFile) {
+		return m_pMemFile.get();
+	}
+	return m_pStdioFile.get();
+}
+
 bool CTextFile::ReopenAsText()
 {
+	if (m_pMemFile) {
+		// there is no text mode for memory, the buffered reader handles the line ends itself
+		m_nInBuffer = m_posInBuffer = 0;
+		m_posInFile = m_pMemFile->Seek(0, CFile::begin);
+		return true;
+	}
+
 	auto fileName = m_strFileName;
 
 	Close();
@@ -204,6 +314,7 @@ void CTextFile::Close()
 		m_pFile.reset();
 		m_strFileName.Empty();
 	}
+	m_pMemFile.reset();
 }
 
 UINT CTextFile::GetEncoding() const
@@ -225,17 +336,20 @@ CStringW CTextFile::GetFilePath() const
 
 ULONGLONG CTextFile::GetPosition() const
 {
-	return m_pStdioFile ? (m_pStdioFile->GetPosition() - m_offset - (m_nInBuffer - m_posInBuffer)) : 0ULL;
+	const CFile* pFile = GetSource();
+	return pFile ? (pFile->GetPosition() - m_offset - (m_nInBuffer - m_posInBuffer)) : 0ULL;
 }
 
 ULONGLONG CTextFile::GetLength() const
 {
-	return m_pStdioFile ? (m_pStdioFile->GetLength() - m_offset) : 0ULL;
+	const CFile* pFile = GetSource();
+	return pFile ? (pFile->GetLength() - m_offset) : 0ULL;
 }
 
 ULONGLONG CTextFile::Seek(LONGLONG lOff, UINT nFrom)
 {
-	if (!m_pStdioFile) {
+	CFile* pFile = GetSource();
+	if (!pFile) {
 		return 0ULL;
 	}
 
@@ -264,7 +378,7 @@ ULONGLONG CTextFile::Seek(LONGLONG lOff, UINT nFrom)
 		if (m_posInBuffer < 0 || m_posInBuffer >= m_nInBuffer) {
 			// If we would have to end up out of the buffer, we just reset it and seek normally
 			m_nInBuffer = m_posInBuffer = 0;
-			newPos = m_pStdioFile->Seek(lOff + m_offset, CStdioFile::begin) - m_offset;
+			newPos = pFile->Seek(lOff + m_offset, CStdioFile::begin) - m_offset;
 		} else { // If we can reuse the buffer, we have nothing special to do
 			newPos = ULONGLONG(lOff);
 		}
@@ -272,7 +386,7 @@ ULONGLONG CTextFile::Seek(LONGLONG lOff, UINT nFrom)
 		if (nFrom == CStdioFile::begin) {
 			lOff += m_offset;
 		}
-		newPos = m_pStdioFile->Seek(lOff, nFrom) - m_offset;
+		newPos = pFile->Seek(lOff, nFrom) - m_offset;
 	}
 
 	m_posInFile = newPos + m_offset + (m_nInBuffer - m_posInBuffer);
@@ -346,7 +460,8 @@ void CTextFile::WriteString(LPCWSTR lpsz/*CStringW str*/)
 
 bool CTextFile::FillBuffer()
 {
-	if (!m_pStdioFile) {
+	CFile* pFile = GetSource();
+	if (!pFile) {
 		return false;
 	}
 
@@ -358,23 +473,46 @@ bool CTextFile::FillBuffer()
 	}
 	m_posInBuffer = 0;
 
-	UINT nBytesRead = m_pStdioFile->Read(&m_buffer[m_nInBuffer], UINT(TEXTFILE_BUFFER_SIZE - m_nInBuffer) * sizeof(char));
+	UINT nBytesRead = pFile->Read(&m_buffer[m_nInBuffer], UINT(TEXTFILE_BUFFER_SIZE - m_nInBuffer) * sizeof(char));
 	if (nBytesRead) {
 		m_nInBuffer += nBytesRead;
 	}
-	m_posInFile = m_pStdioFile->GetPosition();
+	m_posInFile = pFile->GetPosition();
 
 	return nBytesRead > 0;
 }
 
+bool CTextFile::IsAsciiCompatible()
+{
+	if (m_asciiCheckedEncoding != m_encoding) {
+		m_asciiCheckedEncoding = m_encoding;
+		m_bAsciiCompatible = false;
+
+		// stateful encodings like ISO-2022 or HZ use ASCII bytes for escape sequences
+		CPINFO cpinfo;
+		if (GetCPInfo(m_encoding, &cpinfo) && (cpinfo.MaxCharSize <= 2 || m_encoding == 54936)) {
+			char ascii[128];
+			WCHAR wide[128];
+			for (int i = 0; i < 128; i++) {
+				ascii[i] = (char)i;
+			}
+			if (MultiByteToWideChar(m_encoding, 0, ascii, 128, wide, 128) == 128) {
+				m_bAsciiCompatible = std::equal(std::begin(ascii), std::end(ascii), std::begin(wide));
+			}
+		}
+	}
+
+	return m_bAsciiCompatible;
+}
+
 ULONGLONG CTextFile::GetPositionFastBuffered() const
 {
-	return m_pStdioFile ? (m_posInFile - m_offset - (m_nInBuffer - m_posInBuffer)) : 0ULL;
+	return GetSource() ? (m_posInFile - m_offset - (m_nInBuffer - m_posInBuffer)) : 0ULL;
 }
 
 bool CTextFile::ReadString(CStringW& str)
 {
-	if (!m_pStdioFile) {
+	if (!GetSource()) {
 		return false;
 	}
 
@@ -383,20 +521,6 @@ bool CTextFile::ReadString(CStringW& str)
 	str.Truncate(0);
 
 	switch (m_encoding) {
-		case CP_ASCII: {
-				CStringW s;
-				fEOF = !m_pStdioFile->ReadString(s);
-				str = s;
-				// For consistency with other encodings, we continue reading
-				// the file even when a NUL char is encountered.
-				char c;
-				while (fEOF && (m_pStdioFile->Read(&c, sizeof(c)) == sizeof(c))) {
-					str += c;
-					fEOF = !m_pStdioFile->ReadString(s);
-					str += s;
-				}
-			}
-			break;
 		case CP_UTF8: {
 				ULONGLONG lineStartPos = GetPositionFastBuffered();
 				bool bValid = true;
@@ -407,6 +531,16 @@ bool CTextFile::ReadString(CStringW& str)
 					int nCharsRead;
 
 					for (nCharsRead = 0; m_posInBuffer < m_nInBuffer; m_posInBuffer++, nCharsRead++) {
+						// plain ASCII text is copied in blocks up to the next line end or multibyte sequence
+						if (const int n = AsciiRunLength(&m_buffer[m_posInBuffer], int(m_nInBuffer - m_posInBuffer))) {
+							WidenAscii(&m_buffer[m_posInBuffer], n, &m_wbuffer[nCharsRead]);
+							m_posInBuffer += n;
+							nCharsRead += n;
+							if (m_posInBuffer >= m_nInBuffer) {
+								break;
+							}
+						}
+
 						if (Utf8::isSingleByte(m_buffer[m_posInBuffer])) { // 0xxxxxxx
 							m_wbuffer[nCharsRead] = m_buffer[m_posInBuffer] & 0x7f;
 						} else if (Utf8::isFirstOfMultibyte(m_buffer[m_posInBuffer])) {
@@ -567,29 +701,45 @@ bool CTextFile::ReadString(CStringW& str)
 				} while (!bLineEndFound);
 			}
 			break;
+		case CP_ASCII:
+			if (m_pStdioFile) {
+				CStringW s;
+				fEOF = !m_pStdioFile->ReadString(s);
+				str = s;
+				// For consistency with other encodings, we continue reading
+				// the file even when a NUL char is encountered.
+				char c;
+				while (fEOF && (m_pStdioFile->Read(&c, sizeof(c)) == sizeof(c))) {
+					str += c;
+					fEOF = !m_pStdioFile->ReadString(s);
+					str += s;
+				}
+				break;
+			}
+			// memory data is read with the buffered reader
+			[[fallthrough]];
 		default: {
 				bool bLineEndFound = false;
 				fEOF = false;
 
-				do {
-					int nCharsRead;
+				const bool bAsciiCompatible = IsAsciiCompatible();
 
-					for (nCharsRead = 0; m_posInBuffer + nCharsRead < m_nInBuffer; nCharsRead++) {
-						if (m_buffer[m_posInBuffer + nCharsRead] == '\n') {
-							break;
-						} else if (m_buffer[m_posInBuffer + nCharsRead] == '\r') {
-							break;
-						}
-					}
+				do {
+					bool bAscii;
+					const int nCharsRead = FindLineEnd(&m_buffer[m_posInBuffer], int(m_nInBuffer - m_posInBuffer), bAscii);
 
 					if (nCharsRead > 0) {
-						CStringW line;
-						int len = MultiByteToWideChar(m_encoding, 0, &m_buffer[m_posInBuffer], nCharsRead, nullptr, 0);
-						if (len > 0) {
-							line.ReleaseBuffer(MultiByteToWideChar(m_encoding, 0, &m_buffer[m_posInBuffer], nCharsRead, line.GetBuffer(len), len));
+						if (bAscii && bAsciiCompatible) {
+							const int strLen = str.GetLength();
+							WidenAscii(&m_buffer[m_posInBuffer], nCharsRead, str.GetBuffer(strLen + nCharsRead) + strLen);
+							str.ReleaseBuffer(strLen + nCharsRead);
+						} else {
+							// a line never decodes to more characters than it has bytes, so it fits in m_wbuffer
+							const int len = MultiByteToWideChar(m_encoding, 0, &m_buffer[m_posInBuffer], nCharsRead, m_wbuffer.get(), TEXTFILE_BUFFER_SIZE);
+							if (len > 0) {
+								str.Append(m_wbuffer.get(), len);
+							}
 						}
-
-						str.Append(line);
 					}
 
 					m_posInBuffer += nCharsRead;
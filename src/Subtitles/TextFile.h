@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -53,17 +53,25 @@ private:
 	LONGLONG m_posInBuffer = 0;
 	LONGLONG m_nInBuffer = 0;
 
+	UINT m_asciiCheckedEncoding = UINT_MAX;
+	bool m_bAsciiCompatible = false;
+
 	std::unique_ptr<FILE, std::integral_constant<decltype(&fclose), &fclose>> m_pFile;
 	std::unique_ptr<CStdioFile> m_pStdioFile;
+	std::unique_ptr<CMemFile> m_pMemFile;
 	CStringW m_strFileName;
 
 	bool OpenFile(LPCWSTR lpszFileName, LPCWSTR mode);
+	bool OpenSource();
+	CFile* GetSource() const;
 
 public:
 	CTextFile(UINT encoding = CP_ASCII, UINT defaultencoding = CP_ASCII, bool bAutoDetectCodePage = false);
 	virtual ~CTextFile();
 
 	bool Open(LPCWSTR lpszFileName);
+	// reads the text directly from memory, the data must stay valid until Close()
+	bool Open(const BYTE* data, size_t size);
 	bool Save(LPCWSTR lpszFileName, UINT e /*= ASCII*/);
 	void Close();
 
@@ -85,6 +93,7 @@ public:
 protected:
 	bool ReopenAsText();
 	bool FillBuffer();
+	bool IsAsciiCompatible();
 	ULONGLONG GetPositionFastBuffered() const;
 };
 
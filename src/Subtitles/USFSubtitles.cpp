@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -21,45 +21,10 @@
 
 #include "stdafx.h"
 #include "USFSubtitles.h"
-#include <MsXml.h>
-
-#define DeclareNameAndValue(pNode, name, val) \
-	CComBSTR name; \
-	pNode->get_nodeName(&name); \
-	name.ToLower(); \
-	CComVariant val; \
-	pNode->get_nodeValue(&val); \
- 
-#define BeginEnumAttribs(pNode, pChild) \
-	{CComPtr<IXMLDOMNamedNodeMap> pAttribs; \
-	if (SUCCEEDED(pNode->get_attributes(&pAttribs)) && pAttribs != NULL) \
-	{ \
-		CComPtr<IXMLDOMNode> pChild; \
-		for (pAttribs->nextNode(&pChild); pChild; pChild = NULL, pAttribs->nextNode(&pChild)) \
-		{ \
- 
-#define EndEnumAttribs }}}
-
-#define BeginEnumChildren(pNode, pChild) \
-	{CComPtr<IXMLDOMNode> pChild, pNext; \
-	for (pNode->get_firstChild(&pChild); pChild; pNext = NULL, pChild->get_nextSibling(&pNext), pChild = pNext) \
-	{ \
- 
-#define EndEnumChildren }}
-
-static CStringW GetText(CComPtr<IXMLDOMNode> pNode)
-{
-	CComBSTR bstr;
-	pNode->get_text(&bstr);
-
-	return CStringW(bstr);
-}
 
-static CStringW GetXML(CComPtr<IXMLDOMNode> pNode)
+// removes the line breaks and repeated spaces
+static CStringW NormalizeText(CStringW str)
 {
-	CComBSTR bstr;
-	pNode->get_xml(&bstr);
-	CStringW str(bstr);
 	str.Remove('\r');
 	str.Replace('\n', ' ');
 	for (int i = 0; (i = str.Find(L" ", i)) >= 0; ) {
@@ -70,21 +35,48 @@ static CStringW GetXML(CComPtr<IXMLDOMNode> pNode)
 	return str;
 }
 
-static CStringW GetAttrib(CStringW attrib, CComPtr<IXMLDOMNode> pNode)
+static bool IsWhitespace(const std::wstring& text)
 {
-	CStringW ret;
-
-	BeginEnumAttribs(pNode, pChild) {
-		DeclareNameAndValue(pChild, name, val);
+	return text.find_first_not_of(L" \t\r\n") == std::wstring::npos;
+}
 
-		if (CStringW(name) == attrib && val.vt == VT_BSTR) { // TODO: prepare for other types
-			ret = val.bstrVal;
-			break;
+static CStringW GetAttrib(LPCWSTR attrib, const CXmlSaxParser::Attributes& attribs)
+{
+	for (const auto& a : attribs) {
+		if (_wcsicmp(a.name.c_str(), attrib) == 0) {
+			return a.value.c_str();
 		}
 	}
-	EndEnumAttribs
 
-	return ret;
+	return L"";
+}
+
+static void ParseFontstyle(const CXmlSaxParser::Attributes& attribs, fontstyle_t& fs)
+{
+	fs.face = GetAttrib(L"face", attribs);
+	fs.size = GetAttrib(L"size", attribs);
+	fs.color[0] = GetAttrib(L"color", attribs);
+	fs.color[1] = GetAttrib(L"back-color", attribs);
+	fs.color[2] = GetAttrib(L"outline-color", attribs);
+	fs.color[3] = GetAttrib(L"shadow-color", attribs);
+	fs.italic = GetAttrib(L"italic", attribs);
+	fs.weight = GetAttrib(L"weight", attribs);
+	fs.underline = GetAttrib(L"underline", attribs);
+	fs.alpha = GetAttrib(L"alpha", attribs);
+	fs.outline = GetAttrib(L"outline-level", attribs);
+	fs.shadow = GetAttrib(L"shadow-level", attribs);
+	fs.wrap = GetAttrib(L"wrap", attribs);
+}
+
+static void ParsePal(const CXmlSaxParser::Attributes& attribs, posattriblist_t& pal)
+{
+	pal.alignment = GetAttrib(L"alignment", attribs);
+	pal.relativeto = GetAttrib(L"relative-to", attribs);
+	pal.horizontal_margin = GetAttrib(L"horizontal-margin", attribs);
+	pal.vertical_margin = GetAttrib(L"vertical-margin", attribs);
+	pal.rotate[0] = GetAttrib(L"rotate-z", attribs);
+	pal.rotate[1] = GetAttrib(L"rotate-x", attribs);
+	pal.rotate[2] = GetAttrib(L"rotate-y", attribs);
 }
 
 static int TimeToInt(CStringW str)
@@ -186,21 +178,32 @@ CUSFSubtitles::~CUSFSubtitles()
 {
 }
 
-bool CUSFSubtitles::Read(LPCWSTR fn)
+bool CUSFSubtitles::Read(CTextFile* f)
 {
-	VARIANT_BOOL vb;
-	CComPtr<IXMLDOMDocument> pDoc;
-	if (FAILED(pDoc.CoCreateInstance(CLSID_DOMDocument))
-			|| FAILED(pDoc->put_async(VARIANT_FALSE))
-			|| FAILED(pDoc->load(CComVariant(fn), &vb)) || vb != VARIANT_TRUE) {
-		return false;
-	}
-
 	styles.RemoveAll();
 	effects.RemoveAll();
 	texts.RemoveAll();
 
-	if (!ParseUSFSubtitles(CComQIPtr<IXMLDOMNode>(pDoc))) {
+	m_elements.clear();
+	m_rootLevel = 0;
+	m_bRootDone = false;
+	m_pMetaText = nullptr;
+	m_bSubtitle = false;
+	m_text.Free();
+	m_skipLevel = 0;
+	m_postfix.clear();
+
+	CXmlSaxParser parser(*this);
+
+	CStringW line;
+	while (f->ReadString(line)) {
+		line += L'\n';
+		if (!parser.Parse(line.GetString(), line.GetLength())) {
+			return false;
+		}
+	}
+
+	if (!parser.Finish() || !m_bRootDone) {
 		return false;
 	}
 
@@ -445,267 +448,131 @@ bool CUSFSubtitles::ConvertToSTS(CSimpleTextSubtitle& sts)
 	return true;
 }
 
-bool CUSFSubtitles::ParseUSFSubtitles(CComPtr<IXMLDOMNode> pNode)
+void CUSFSubtitles::StartElement(const std::wstring& name, const CXmlSaxParser::Attributes& attribs)
 {
-	DeclareNameAndValue(pNode, name, val);
+	CStringW elem(name.c_str());
+	elem.MakeLower();
+	m_elements.emplace_back(elem);
 
-	if (name == L"usfsubtitles") {
-		// metadata
+	const size_t level = m_elements.size();
 
-		BeginEnumChildren(pNode, pChild) {
-			DeclareNameAndValue(pChild, name2, val2);
-
-			if (name2 == L"metadata") {
-				ParseMetadata(pChild, metadata);
-			}
+	if (!m_rootLevel) {
+		if (!m_bRootDone && elem == L"usfsubtitles") {
+			m_rootLevel = level;
 		}
-		EndEnumChildren
-
-		// styles
+		return;
+	}
 
-		BeginEnumChildren(pNode, pChild) {
-			DeclareNameAndValue(pChild, name2, val2);
+	if (level <= m_rootLevel + 1) {
+		return;
+	}
 
-			if (name2 == L"styles") {
-				BeginEnumChildren(pChild, pGrandChild) { // :)
-					DeclareNameAndValue(pGrandChild, name3, val3);
+	const CStringW& section = m_elements[m_rootLevel];
 
-					if (name3 == L"style") {
-						CAutoPtr<style_t> s(DNew style_t);
-						if (s) {
-							ParseStyle(pGrandChild, s);
-							styles.AddTail(s);
-						}
-					}
+	if (section == L"metadata") {
+		StartMetadata(elem, attribs, level);
+	} else if (section == L"styles") {
+		if (level == m_rootLevel + 2) {
+			if (elem == L"style") {
+				m_style.Attach(DNew style_t);
+				if (m_style) {
+					m_style->name = GetAttrib(L"name", attribs);
 				}
-				EndEnumChildren
+			}
+		} else if (m_style) {
+			if (elem == L"fontstyle") {
+				ParseFontstyle(attribs, m_style->fontstyle);
+			} else if (elem == L"position") {
+				ParsePal(attribs, m_style->pal);
 			}
 		}
-		EndEnumChildren
-
-		// effects
-
-		BeginEnumChildren(pNode, pChild) {
-			DeclareNameAndValue(pChild, name2, val2);
-
-			if (name2 == L"effects") {
-				BeginEnumChildren(pChild, pGrandChild) { // :)
-					DeclareNameAndValue(pGrandChild, name3, val3);
-
-					if (name3 == L"effect") {
-						CAutoPtr<effect_t> e(DNew effect_t);
-						if (e) {
-							ParseEffect(pGrandChild, e);
-							effects.AddTail(e);
-						}
-					}
+	} else if (section == L"effects") {
+		if (level == m_rootLevel + 2) {
+			if (elem == L"effect") {
+				m_effect.Attach(DNew effect_t);
+				if (m_effect) {
+					m_effect->name = GetAttrib(L"name", attribs);
 				}
-				EndEnumChildren
+			}
+		} else if (m_effect && elem == L"keyframe" && m_elements[level - 2] == L"keyframes") {
+			CAutoPtr<keyframe_t> k(DNew keyframe_t);
+			if (k) {
+				k->position = GetAttrib(L"position", attribs);
+				m_effect->keyframes.AddTail(k);
 			}
 		}
-		EndEnumChildren
-
-		// subtitles
-
-		BeginEnumChildren(pNode, pChild) {
-			DeclareNameAndValue(pChild, name2, val2);
-
-			if (name2 == L"subtitles") {
-				BeginEnumChildren(pChild, pGrandChild) { // :)
-					DeclareNameAndValue(pGrandChild, name3, val3);
-
-					if (name3 == L"subtitle") {
-						CStringW sstart = GetAttrib(L"start", pGrandChild);
-						CStringW sstop = GetAttrib(L"stop", pGrandChild);
-						CStringW sduration = GetAttrib(L"duration", pGrandChild);
-						if (sstart.IsEmpty() || (sstop.IsEmpty() && sduration.IsEmpty())) {
-							continue;
-						}
-
-						int start = TimeToInt(sstart);
-						int stop = !sstop.IsEmpty() ? TimeToInt(sstop) : (start + TimeToInt(sduration));
-
-						ParseSubtitle(pGrandChild, start, stop);
-					}
+	} else if (section == L"subtitles") {
+		if (level == m_rootLevel + 2) {
+			m_bSubtitle = false;
+			if (elem == L"subtitle") {
+				CStringW sstart = GetAttrib(L"start", attribs);
+				CStringW sstop = GetAttrib(L"stop", attribs);
+				CStringW sduration = GetAttrib(L"duration", attribs);
+				if (!sstart.IsEmpty() && (!sstop.IsEmpty() || !sduration.IsEmpty())) {
+					m_start = TimeToInt(sstart);
+					m_stop = !sstop.IsEmpty() ? TimeToInt(sstop) : (m_start + TimeToInt(sduration));
+					m_bSubtitle = true;
 				}
-				EndEnumChildren
 			}
-		}
-		EndEnumChildren
-
-		return true;
-	}
-
-	BeginEnumChildren(pNode, pChild) {
-		if (ParseUSFSubtitles(pChild)) {
-			return true;
-		}
-	}
-	EndEnumChildren
-
-	return false;
-}
-
-void CUSFSubtitles::ParseMetadata(CComPtr<IXMLDOMNode> pNode, metadata_t& m)
-{
-	DeclareNameAndValue(pNode, name, val);
-
-	if (name == L"title") {
-		m.title = GetText(pNode);
-	} else if (name == L"date") {
-		m.date = GetText(pNode);
-	} else if (name == L"comment") {
-		m.comment = GetText(pNode);
-	} else if (name == L"author") {
-		BeginEnumChildren(pNode, pChild) {
-			DeclareNameAndValue(pChild, name2, val2);
-
-			if (name2 == L"name") {
-				m.author.name = GetText(pChild);
-			} else if (name2 == L"email") {
-				m.author.email = GetText(pChild);
-			} else if (name2 == L"url") {
-				m.author.url = GetText(pChild);
+		} else if (m_text) {
+			StartText(elem, attribs, level);
+		} else if (m_bSubtitle && (elem == L"text" || elem == L"karaoke")) {
+			m_text.Attach(DNew text_t);
+			if (m_text) {
+				m_text->start = m_start;
+				m_text->stop = m_stop;
+				m_text->style = GetAttrib(L"style", attribs);
+				m_text->effect = GetAttrib(L"effect", attribs);
+				ParsePal(attribs, m_text->pal);
+				m_textLevel = level;
 			}
 		}
-		EndEnumChildren
-
-		return;
-	} else if (name == L"language") {
-		m.language.text = GetText(pNode);
-		m.language.code = GetAttrib(L"code", pNode);
-	} else if (name == L"languageext") {
-		m.languageext.text = GetText(pNode);
-		m.languageext.code = GetAttrib(L"code", pNode);
-	}
-
-	BeginEnumChildren(pNode, pChild) {
-		ParseMetadata(pChild, metadata);
 	}
-	EndEnumChildren
 }
 
-void CUSFSubtitles::ParseStyle(CComPtr<IXMLDOMNode> pNode, style_t* s)
+void CUSFSubtitles::StartMetadata(const CStringW& name, const CXmlSaxParser::Attributes& attribs, size_t level)
 {
-	DeclareNameAndValue(pNode, name, val);
-
-	if (name == L"style") {
-		s->name = GetAttrib(L"name", pNode);
-	} else if (name == L"fontstyle") {
-		ParseFontstyle(pNode, s->fontstyle);
-		return;
-	} else if (name == L"position") {
-		ParsePal(pNode, s->pal);
+	if (m_pMetaText) {
 		return;
 	}
 
-	BeginEnumChildren(pNode, pChild) {
-		ParseStyle(pChild, s);
-	}
-	EndEnumChildren
-}
-
-void CUSFSubtitles::ParseFontstyle(CComPtr<IXMLDOMNode> pNode, fontstyle_t& fs)
-{
-	fs.face = GetAttrib(L"face", pNode);
-	fs.size = GetAttrib(L"size", pNode);
-	fs.color[0] = GetAttrib(L"color", pNode);
-	fs.color[1] = GetAttrib(L"back-color", pNode);
-	fs.color[2] = GetAttrib(L"outline-color", pNode);
-	fs.color[3] = GetAttrib(L"shadow-color", pNode);
-	fs.italic = GetAttrib(L"italic", pNode);
-	fs.weight = GetAttrib(L"weight", pNode);
-	fs.underline = GetAttrib(L"underline", pNode);
-	fs.alpha = GetAttrib(L"alpha", pNode);
-	fs.outline = GetAttrib(L"outline-level", pNode);
-	fs.shadow = GetAttrib(L"shadow-level", pNode);
-	fs.wrap = GetAttrib(L"wrap", pNode);
-}
-
-void CUSFSubtitles::ParsePal(CComPtr<IXMLDOMNode> pNode, posattriblist_t& pal)
-{
-	pal.alignment = GetAttrib(L"alignment", pNode);
-	pal.relativeto = GetAttrib(L"relative-to", pNode);
-	pal.horizontal_margin = GetAttrib(L"horizontal-margin", pNode);
-	pal.vertical_margin = GetAttrib(L"vertical-margin", pNode);
-	pal.rotate[0] = GetAttrib(L"rotate-z", pNode);
-	pal.rotate[1] = GetAttrib(L"rotate-x", pNode);
-	pal.rotate[2] = GetAttrib(L"rotate-y", pNode);
-}
-
-void CUSFSubtitles::ParseEffect(CComPtr<IXMLDOMNode> pNode, effect_t* e)
-{
-	DeclareNameAndValue(pNode, name, val);
-
-	if (name == L"effect") {
-		e->name = GetAttrib(L"name", pNode);
-	} else if (name == L"keyframes") {
-		BeginEnumChildren(pNode, pChild) {
-			DeclareNameAndValue(pChild, name2, val2);
-
-			if (name2 == L"keyframe") {
-				CAutoPtr<keyframe_t> k(DNew keyframe_t);
-				if (k) {
-					ParseKeyframe(pChild, k);
-					e->keyframes.AddTail(k);
-				}
+	const bool bInAuthor = std::find(m_elements.begin() + m_rootLevel + 1, m_elements.end() - 1, L"author") != m_elements.end() - 1;
+	if (bInAuthor) {
+		// only the direct children of <author>
+		if (m_elements[level - 2] == L"author") {
+			if (name == L"name") {
+				m_pMetaText = &metadata.author.name;
+			} else if (name == L"email") {
+				m_pMetaText = &metadata.author.email;
+			} else if (name == L"url") {
+				m_pMetaText = &metadata.author.url;
 			}
 		}
-		EndEnumChildren
-
-		return;
-	}
-
-	BeginEnumChildren(pNode, pChild) {
-		ParseEffect(pChild, e);
+	} else if (name == L"title") {
+		m_pMetaText = &metadata.title;
+	} else if (name == L"date") {
+		m_pMetaText = &metadata.date;
+	} else if (name == L"comment") {
+		m_pMetaText = &metadata.comment;
+	} else if (name == L"language") {
+		m_pMetaText = &metadata.language.text;
+		metadata.language.code = GetAttrib(L"code", attribs);
+	} else if (name == L"languageext") {
+		m_pMetaText = &metadata.languageext.text;
+		metadata.languageext.code = GetAttrib(L"code", attribs);
 	}
-	EndEnumChildren
-}
-
-void CUSFSubtitles::ParseKeyframe(CComPtr<IXMLDOMNode> pNode, keyframe_t* k)
-{
-	DeclareNameAndValue(pNode, name, val);
 
-	if (name == L"keyframe") {
-		k->position = GetAttrib(L"position", pNode);
-	} else if (name == L"fontstyle") {
-		ParseFontstyle(pNode, k->fontstyle);
-		return;
-	} else if (name == L"position") {
-		ParsePal(pNode, k->pal);
-		return;
+	if (m_pMetaText) {
+		m_metaLevel = level;
+		m_metaBuffer.Empty();
 	}
 }
 
-void CUSFSubtitles::ParseSubtitle(CComPtr<IXMLDOMNode> pNode, int start, int stop)
+void CUSFSubtitles::StartText(const CStringW& name, const CXmlSaxParser::Attributes& attribs, size_t level)
 {
-	DeclareNameAndValue(pNode, name, val);
-
-	if (name == L"text" || name == L"karaoke") {
-		CAutoPtr<text_t> t(DNew text_t);
-		if (t) {
-			t->start = start;
-			t->stop = stop;
-			t->style = GetAttrib(L"style", pNode);
-			t->effect = GetAttrib(L"effect", pNode);
-			ParsePal(pNode, t->pal);
-			ParseText(pNode, t->str);
-			texts.AddTail(t);
-		}
-
+	if (m_skipLevel) {
 		return;
 	}
-	//	else if
-
-	BeginEnumChildren(pNode, pChild) {
-		ParseSubtitle(pChild, start, stop);
-	}
-	EndEnumChildren
-}
-
-void CUSFSubtitles::ParseText(CComPtr<IXMLDOMNode> pNode, CStringW& str)
-{
-	DeclareNameAndValue(pNode, name, val);
 
 	CStringW prefix, postfix;
 
@@ -720,7 +587,7 @@ void CUSFSubtitles::ParseText(CComPtr<IXMLDOMNode> pNode, CStringW& str)
 		postfix = L"{\\u}";
 	} else if (name == L"font") {
 		fontstyle_t fs;
-		ParseFontstyle(pNode, fs);
+		ParseFontstyle(attribs, fs);
 
 		if (!fs.face.IsEmpty()) {
 			prefix += L"{\\fn" + fs.face + L"}";
@@ -749,30 +616,63 @@ void CUSFSubtitles::ParseText(CComPtr<IXMLDOMNode> pNode, CStringW& str)
 			}
 		}
 	} else if (name == L"k") {
-		int t = wcstol(GetAttrib(L"t", pNode), NULL, 10);
-		CStringW s;
-		s.Format(L"{\\kf%d}", t / 10);
-		str += s;
-		return;
+		int t = wcstol(GetAttrib(L"t", attribs), NULL, 10);
+		prefix.Format(L"{\\kf%d}", t / 10);
+		m_skipLevel = level;
 	} else if (name == L"br") {
-		str += L"\\N";
-		return;
-	} else if (name == L"#text") {
-		str += GetXML(pNode);
+		prefix = L"\\N";
+		m_skipLevel = level;
+	}
+
+	m_text->str += prefix;
+	m_postfix.emplace_back(postfix);
+}
+
+void CUSFSubtitles::EndElement(const std::wstring& name)
+{
+	const size_t level = m_elements.size();
+	if (!level) {
 		return;
 	}
 
-	BeginEnumChildren(pNode, pChild) {
-		CStringW s;
-		ParseText(pChild, s);
-		str += s;
+	if (m_rootLevel) {
+		if (level == m_rootLevel) {
+			m_rootLevel = 0;
+			m_bRootDone = true;
+		} else if (m_pMetaText) {
+			if (level == m_metaLevel) {
+				*m_pMetaText = NormalizeText(m_metaBuffer).Trim();
+				m_pMetaText = nullptr;
+			}
+		} else if (m_text) {
+			if (level == m_textLevel) {
+				texts.AddTail(m_text);
+				m_postfix.clear();
+				m_skipLevel = 0;
+			} else if (!m_skipLevel || level == m_skipLevel) {
+				m_skipLevel = 0;
+				m_text->str += m_postfix.back();
+				m_postfix.pop_back();
+			}
+		} else if (level == m_rootLevel + 2) {
+			if (m_style) {
+				styles.AddTail(m_style);
+			}
+			if (m_effect) {
+				effects.AddTail(m_effect);
+			}
+			m_bSubtitle = false;
+		}
 	}
-	EndEnumChildren
 
-	str = prefix + str + postfix;
+	m_elements.pop_back();
 }
 
-void CUSFSubtitles::ParseShape(CComPtr<IXMLDOMNode> pNode)
+void CUSFSubtitles::Characters(const std::wstring& text)
 {
-	// no specs on this yet
+	if (m_pMetaText) {
+		m_metaBuffer += text.c_str();
+	} else if (m_text && !m_skipLevel && !IsWhitespace(text)) {
+		m_text->str += NormalizeText(text.c_str());
+	}
 }
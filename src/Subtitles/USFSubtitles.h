@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2018 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -23,6 +23,7 @@
 
 #include <atlcoll.h>
 #include "STS.h"
+#include "XmlSaxParser.h"
 
 // metadata
 typedef struct {
@@ -65,24 +66,39 @@ typedef struct {
 	posattriblist_t pal;
 } text_t;
 
-class CUSFSubtitles
+class CUSFSubtitles : private CXmlSaxParser::Handler
 {
-	bool ParseUSFSubtitles(CComPtr<IXMLDOMNode> pNode);
-	void ParseMetadata(CComPtr<IXMLDOMNode> pNode, metadata_t& m);
-	void ParseStyle(CComPtr<IXMLDOMNode> pNode, style_t* s);
-	void ParseFontstyle(CComPtr<IXMLDOMNode> pNode, fontstyle_t& fs);
-	void ParsePal(CComPtr<IXMLDOMNode> pNode, posattriblist_t& pal);
-	void ParseEffect(CComPtr<IXMLDOMNode> pNode, effect_t* e);
-	void ParseKeyframe(CComPtr<IXMLDOMNode> pNode, keyframe_t* k);
-	void ParseSubtitle(CComPtr<IXMLDOMNode> pNode, int start, int stop);
-	void ParseText(CComPtr<IXMLDOMNode> pNode, CStringW& assstr);
-	void ParseShape(CComPtr<IXMLDOMNode> pNode);
+	// parser state, the document is read in one pass
+	std::vector<CStringW> m_elements; // lower case names of the open elements
+	size_t m_rootLevel = 0;            // level of <USFSubtitles>, 0 outside of it
+	bool m_bRootDone = false;
+
+	CStringW* m_pMetaText = nullptr;   // metadata field that receives the text of the current element
+	size_t m_metaLevel = 0;
+	CStringW m_metaBuffer;
+
+	CAutoPtr<style_t> m_style;
+	CAutoPtr<effect_t> m_effect;
+
+	bool m_bSubtitle = false;
+	int m_start = 0, m_stop = 0;
+	CAutoPtr<text_t> m_text;
+	size_t m_textLevel = 0;
+	size_t m_skipLevel = 0;            // content of <k> and <br> is ignored
+	std::vector<CStringW> m_postfix;   // closing tags of the open text markup
+
+	void StartElement(const std::wstring& name, const CXmlSaxParser::Attributes& attribs) override;
+	void EndElement(const std::wstring& name) override;
+	void Characters(const std::wstring& text) override;
+
+	void StartMetadata(const CStringW& name, const CXmlSaxParser::Attributes& attribs, size_t level);
+	void StartText(const CStringW& name, const CXmlSaxParser::Attributes& attribs, size_t level);
 
 public:
 	CUSFSubtitles();
 	virtual ~CUSFSubtitles();
 
-	bool Read(LPCWSTR fn);
+	bool Read(CTextFile* f);
 	//bool Write(LPCWSTR fn); // TODO
 
 	metadata_t metadata;
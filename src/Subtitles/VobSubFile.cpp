@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -227,6 +227,87 @@ CString FindLangFromId(WORD id)
 	return CString(lang_tbl[find_lang(id)].lang_long);
 }
 
+//
+// CVobSubData
+//
+
+bool CVobSubData::Map(LPCWSTR fn)
+{
+	Unmap();
+
+	HANDLE hFile = CreateFileW(fn, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart <= 0 || size.QuadPart > UINT_MAX) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(hFile);
+	if (!hMapping) {
+		return false;
+	}
+
+	// the view keeps the mapping alive
+	void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(hMapping);
+	if (!pView) {
+		return false;
+	}
+
+	CMemFile::Close();
+	Attach((BYTE*)pView, (UINT)size.QuadPart, 0);
+	m_pView = pView;
+
+	return true;
+}
+
+void CVobSubData::Unmap()
+{
+	if (m_pView) {
+		Detach();
+		UnmapViewOfFile(m_pView);
+		m_pView = nullptr;
+
+		m_nGrowBytes = m_nMemGrowBytes;
+		m_bAutoDelete = TRUE;
+	}
+}
+
+bool CVobSubData::Load()
+{
+	if (!m_pView) {
+		return true;
+	}
+
+	const ULONGLONG pos = GetPosition();
+	const UINT size = (UINT)GetLength();
+
+	const BYTE* pView = Detach();
+	m_nGrowBytes = m_nMemGrowBytes;
+	m_bAutoDelete = TRUE;
+
+	bool ret = true;
+	try {
+		Write(pView, size);
+		Seek(pos, CFile::begin);
+	}
+	catch (CMemoryException* e) {
+		e->Delete();
+		CMemFile::Close();
+		ret = false;
+	}
+
+	UnmapViewOfFile(m_pView);
+	m_pView = nullptr;
+
+	return ret;
+}
+
 //
 // CVobSubFile
 //
@@ -234,6 +315,7 @@ CString FindLangFromId(WORD id)
 CVobSubFile::CVobSubFile(CCritSec* pLock)
 	: CSubPicProviderImpl(pLock)
 	, m_sub(1024*1024)
+	, m_frameCache(L"CVobSubFile::m_frameCache", 16)
 	, m_nLang(0)
 {
 }
@@ -412,8 +494,10 @@ void CVobSubFile::Close()
 {
 	InitSettings();
 	m_title.Empty();
+	m_sub.Unmap();
 	m_sub.SetLength(0);
 	m_img.Invalidate();
+	m_frameCache.Clear();
 	m_nLang = -1;
 	for (auto& sl : m_langs) {
 		sl.id = 0;
@@ -756,6 +840,16 @@ bool CVobSubFile::ReadIdx(CString fn, int& ver)
 
 bool CVobSubFile::ReadSub(CString fn)
 {
+	// packets are read directly from the mapped file when they are needed
+	if (m_sub.Map(fn)) {
+		DWORD dw;
+		if (m_sub.Read(&dw, sizeof(dw)) == sizeof(dw) && dw == 0xba010000) {
+			m_sub.SeekToBegin();
+			return true;
+		}
+		m_sub.Unmap();
+	}
+
 	CFile f;
 	if (!f.Open(fn, CFile::modeRead|CFile::typeBinary|CFile::shareDenyNone)) {
 		return false;
@@ -1087,6 +1181,11 @@ bool CVobSubFile::WriteIdx(CString fn)
 
 bool CVobSubFile::WriteSub(CString fn)
 {
+	// the target can be the mapped source file
+	if (!m_sub.Load()) {
+		return false;
+	}
+
 	CFile f;
 	if (!f.Open(fn, CFile::modeCreate|CFile::modeWrite|CFile::typeBinary|CFile::shareDenyWrite)) {
 		return false;
@@ -1202,6 +1301,37 @@ bool CVobSubFile::GetFrame(size_t idx, int iLang /*= -1*/, REFERENCE_TIME rt /*=
 
 	if (m_img.nLang != iLang || m_img.nIdx != idx
 			|| (sp[idx].bAnimated && sp[idx].start + m_img.tCurrent <= rt)) {
+		if (m_bFrameCacheCustomPal != m_bCustomPal || m_nFrameCacheTridx != m_tridx
+				|| memcmp(m_frameCacheCuspal, m_cuspal, sizeof(m_cuspal))) {
+			m_frameCache.Clear();
+			m_bFrameCacheCustomPal = m_bCustomPal;
+			m_nFrameCacheTridx = m_tridx;
+			memcpy(m_frameCacheCuspal, m_cuspal, sizeof(m_cuspal));
+		}
+
+		const ULONGLONG key = ((ULONGLONG)iLang << 32) | idx;
+		CVobSubFrameSharedPtr pFrame;
+		if (!sp[idx].bAnimated && m_frameCache.Lookup(key, pFrame)
+				&& m_img.Alloc(pFrame->rect.Width(), pFrame->rect.Height())) {
+			memcpy(m_img.lpPixels, pFrame->pixels.data(), pFrame->pixels.size() * sizeof(RGBQUAD));
+			m_img.rect = pFrame->rect;
+			m_img.bForced = pFrame->bForced;
+			m_img.bAnimated = false;
+			m_img.tCurrent = pFrame->tCurrent;
+			memcpy(m_img.pal, pFrame->pal, sizeof(m_img.pal));
+			m_img.bCustomPal = m_bCustomPal;
+			m_img.tridx = m_tridx;
+			m_img.orgpal = m_orgpal;
+			m_img.cuspal = m_cuspal;
+
+			m_img.start = sp[idx].start;
+			m_img.delay = sp[idx].stop - sp[idx].start;
+			m_img.nIdx = idx;
+			m_img.nLang = iLang;
+
+			return (m_bOnlyShowForcedSubs ? m_img.bForced : true);
+		}
+
 		int packetsize = 0, datasize = 0;
 		std::unique_ptr<BYTE[]> buff(GetPacket(idx, packetsize, datasize, iLang));
 		if (!buff || packetsize <= 0 || datasize <= 0) {
@@ -1221,6 +1351,16 @@ bool CVobSubFile::GetFrame(size_t idx, int iLang /*= -1*/, REFERENCE_TIME rt /*=
 
 		m_img.nIdx = idx;
 		m_img.nLang = iLang;
+
+		if (!m_img.bAnimated) {
+			pFrame = std::make_shared<CVobSubFrame>();
+			pFrame->rect = m_img.rect;
+			pFrame->bForced = m_img.bForced;
+			pFrame->tCurrent = m_img.tCurrent;
+			memcpy(pFrame->pal, m_img.pal, sizeof(pFrame->pal));
+			pFrame->pixels.assign(m_img.lpPixels, m_img.lpPixels + m_img.rect.Width() * m_img.rect.Height());
+			m_frameCache.SetAt(key, pFrame);
+		}
 	}
 
 	return (m_bOnlyShowForcedSubs ? m_img.bForced : true);
@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2023 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -23,6 +23,7 @@
 
 #include <atlcoll.h>
 #include "VobSubImage.h"
+#include "RenderingCache.h"
 #include "SubPic/SubPicProviderImpl.h"
 
 #define VOBSUBIDXVER 7
@@ -77,6 +78,40 @@ public:
 	void SetAlignment(bool bAlign, int x, int y, int hor = 1, int ver = 1);
 };
 
+// CMemFile that can also be attached to a read-only memory-mapped file,
+// only the pages that are actually read are loaded from the disk.
+class CVobSubData : public CMemFile
+{
+	void* m_pView = nullptr;
+	const UINT m_nMemGrowBytes;
+
+public:
+	CVobSubData(UINT nGrowBytes) : CMemFile(nGrowBytes), m_nMemGrowBytes(nGrowBytes) {}
+	~CVobSubData() { Unmap(); }
+
+	bool Map(LPCWSTR fn);
+	void Unmap();
+	bool Load(); // copies the mapped data to memory
+	bool IsMapped() const { return m_pView != nullptr; }
+};
+
+// decoded non-animated subtitle image
+struct CVobSubFrame {
+	CRect rect;
+	bool bForced = false;
+	int tCurrent = 0;
+	CVobSubImage::SubPal pal[4] = {};
+	std::vector<RGBQUAD> pixels;
+};
+
+typedef std::shared_ptr<CVobSubFrame> CVobSubFrameSharedPtr;
+
+template<> struct CRenderingCacheEntrySize<CVobSubFrameSharedPtr> {
+	size_t operator()(const CVobSubFrameSharedPtr& value) const {
+		return sizeof(CVobSubFrame) + value->pixels.size() * sizeof(RGBQUAD);
+	}
+};
+
 class __declspec(uuid("998D4C9A-460F-4de6-BDCD-35AB24F94ADF"))
 	CVobSubFile : public CVobSubSettings, public ISubStream, public CSubPicProviderImpl
 {
@@ -105,7 +140,13 @@ protected:
 	bool ReadIdx(CString fn, int& ver), ReadSub(CString fn), ReadRar(CString fn), ReadIfo(CString fn);
 	bool WriteIdx(CString fn), WriteSub(CString fn);
 
-	CMemFile m_sub;
+	CVobSubData m_sub;
+
+	// recently decoded frames by language and index, valid for the palette settings below
+	CRenderingCache<ULONGLONG, CVobSubFrameSharedPtr> m_frameCache;
+	bool m_bFrameCacheCustomPal = false;
+	int m_nFrameCacheTridx = 0;
+	RGBQUAD m_frameCacheCuspal[4] = {};
 
 	BYTE* GetPacket(size_t idx, int& packetsize, int& datasize, int nLang = -1);
 	const SubPos* GetFrameInfo(size_t idx, int iLang = -1) const;
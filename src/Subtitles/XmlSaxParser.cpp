@@ -0,0 +1,320 @@
+/*
+ * (C) 2026 see Authors.txt
+ *
+ * This file is part of MPC-BE.
+ *
+ * MPC-BE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MPC-BE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "stdafx.h"
+#include "XmlSaxParser.h"
+#include <algorithm>
+#include <cwchar>
+#include <string_view>
+
+static inline bool IsXmlSpace(const wchar_t c)
+{
+	return c == L' ' || c == L'\t' || c == L'\r' || c == L'\n';
+}
+
+CXmlSaxParser::CXmlSaxParser(Handler& handler)
+	: m_handler(handler)
+{
+}
+
+bool CXmlSaxParser::Parse(const wchar_t* data, size_t len)
+{
+	if (m_bError) {
+		return false;
+	}
+
+	m_pending.append(data, len);
+
+	size_t pos = 0;
+	while (pos < m_pending.size()) {
+		if (m_pending[pos] != L'<') {
+			const size_t lt = m_pending.find(L'<', pos);
+			if (lt == std::wstring::npos) {
+				break; // the text may continue in the next part
+			}
+			if (m_depth) {
+				m_text.clear();
+				AppendDecoded(m_text, &m_pending[pos], &m_pending[lt]);
+				m_handler.Characters(m_text);
+			}
+			pos = lt;
+		}
+
+		const size_t next = ParseMarkup(pos);
+		if (m_bError) {
+			return false;
+		}
+		if (next == pos) {
+			break; // incomplete markup
+		}
+		pos = next;
+	}
+
+	m_pending.erase(0, pos);
+
+	return true;
+}
+
+bool CXmlSaxParser::Finish()
+{
+	if (m_bError) {
+		return false;
+	}
+
+	size_t pos = 0;
+	while (pos < m_pending.size() && IsXmlSpace(m_pending[pos])) {
+		pos++;
+	}
+	const bool bComplete = (pos == m_pending.size());
+	m_pending.clear();
+
+	return bComplete && m_depth == 0;
+}
+
+// returns the position after the markup at pos, pos if the markup is not complete yet
+size_t CXmlSaxParser::ParseMarkup(size_t pos)
+{
+	const wchar_t* p = &m_pending[pos];
+	const size_t left = m_pending.size() - pos;
+
+	auto skipTo = [&](const wchar_t* terminator, size_t from) -> size_t {
+		const size_t end = m_pending.find(terminator, pos + from);
+		return end == std::wstring::npos ? pos : end + wcslen(terminator);
+	};
+
+	if (left < 2) {
+		return pos;
+	}
+
+	if (p[1] == L'!') {
+		if (left < 4) {
+			return pos;
+		}
+		if (p[2] == L'-' && p[3] == L'-') {
+			return skipTo(L"-->", 4);
+		}
+		if (left < 9) {
+			return pos;
+		}
+		if (wcsncmp(p, L"<![CDATA[", 9) == 0) {
+			const size_t end = m_pending.find(L"]]>", pos + 9);
+			if (end == std::wstring::npos) {
+				return pos;
+			}
+			if (m_depth) {
+				m_text.assign(m_pending, pos + 9, end - pos - 9);
+				m_handler.Characters(m_text);
+			}
+			return end + 3;
+		}
+		// <!DOCTYPE ...> with an optional internal subset
+		const size_t gt = m_pending.find(L'>', pos);
+		const size_t bracket = m_pending.find(L'[', pos);
+		if (bracket != std::wstring::npos && bracket < gt) {
+			return skipTo(L"]>", bracket - pos);
+		}
+		return gt == std::wstring::npos ? pos : gt + 1;
+	}
+
+	if (p[1] == L'?') {
+		return skipTo(L"?>", 2);
+	}
+
+	if (p[1] == L'/') {
+		const size_t gt = m_pending.find(L'>', pos);
+		if (gt == std::wstring::npos) {
+			return pos;
+		}
+		size_t nameEnd = gt;
+		while (nameEnd > pos + 2 && IsXmlSpace(m_pending[nameEnd - 1])) {
+			nameEnd--;
+		}
+		if (m_depth == 0) {
+			m_bError = true;
+			return pos;
+		}
+		m_depth--;
+		m_name.assign(m_pending, pos + 2, nameEnd - pos - 2);
+		m_handler.EndElement(m_name);
+		return gt + 1;
+	}
+
+	// start tag, '>' may also be used in the attribute values
+	wchar_t quote = 0;
+	for (size_t i = pos + 1; i < m_pending.size(); i++) {
+		const wchar_t c = m_pending[i];
+		if (quote) {
+			if (c == quote) {
+				quote = 0;
+			}
+		} else if (c == L'"' || c == L'\'') {
+			quote = c;
+		} else if (c == L'>') {
+			if (!ParseStartTag(p + 1, &m_pending[i])) {
+				m_bError = true;
+				return pos;
+			}
+			return i + 1;
+		}
+	}
+
+	return pos;
+}
+
+// parses "name attr="value" ... [/]" of a start tag
+bool CXmlSaxParser::ParseStartTag(const wchar_t* p, const wchar_t* end)
+{
+	bool bEmpty = false;
+	if (end > p && end[-1] == L'/') {
+		bEmpty = true;
+		end--;
+	}
+
+	const wchar_t* name = p;
+	while (p < end && !IsXmlSpace(*p)) {
+		p++;
+	}
+	if (p == name) {
+		return false;
+	}
+	m_name.assign(name, p);
+
+	m_attribs.clear();
+	for (;;) {
+		while (p < end && IsXmlSpace(*p)) {
+			p++;
+		}
+		if (p == end) {
+			break;
+		}
+
+		const wchar_t* attrName = p;
+		while (p < end && *p != L'=' && !IsXmlSpace(*p)) {
+			p++;
+		}
+		const wchar_t* attrNameEnd = p;
+		while (p < end && IsXmlSpace(*p)) {
+			p++;
+		}
+		if (p == end || *p != L'=' || attrName == attrNameEnd) {
+			return false;
+		}
+		p++;
+		while (p < end && IsXmlSpace(*p)) {
+			p++;
+		}
+		if (p == end || (*p != L'"' && *p != L'\'')) {
+			return false;
+		}
+		const wchar_t quote = *p++;
+		const wchar_t* value = p;
+		while (p < end && *p != quote) {
+			p++;
+		}
+		if (p == end) {
+			return false;
+		}
+
+		auto& attrib = m_attribs.emplace_back();
+		attrib.name.assign(attrName, attrNameEnd);
+		AppendDecoded(attrib.value, value, p);
+		p++;
+	}
+
+	m_handler.StartElement(m_name, m_attribs);
+	if (bEmpty) {
+		m_handler.EndElement(m_name);
+	} else {
+		m_depth++;
+	}
+
+	return true;
+}
+
+void CXmlSaxParser::AppendDecoded(std::wstring& dst, const wchar_t* p, const wchar_t* end)
+{
+	while (p < end) {
+		const wchar_t* amp = std::find(p, end, L'&');
+		dst.append(p, amp);
+		if (amp == end) {
+			break;
+		}
+
+		const wchar_t* semicolon = std::find(amp, std::min(end, amp + 12), L';');
+		p = amp + 1;
+		if (semicolon == std::min(end, amp + 12)) {
+			dst += L'&';
+			continue;
+		}
+
+		const std::wstring_view ref(amp + 1, semicolon - amp - 1);
+		unsigned long c = 0;
+		if (ref == L"lt") {
+			c = L'<';
+		} else if (ref == L"gt") {
+			c = L'>';
+		} else if (ref == L"amp") {
+			c = L'&';
+		} else if (ref == L"quot") {
+			c = L'"';
+		} else if (ref == L"apos") {
+			c = L'\'';
+		} else if (ref.size() > 1 && ref[0] == L'#') {
+			wchar_t* numEnd = nullptr;
+			c = (ref[1] == L'x' || ref[1] == L'X')
+				? wcstoul(amp + 3, &numEnd, 16)
+				: wcstoul(amp + 2, &numEnd, 10);
+			if (numEnd != semicolon || c > 0x10FFFF) {
+				c = 0;
+			}
+		}
+
+		if (!c) {
+			dst += L'&'; // unknown entity, keep it as written
+			continue;
+		}
+
+		if (c > 0xFFFF) {
+			c -= 0x10000;
+			dst += (wchar_t)(0xD800 | (c >> 10));
+			dst += (wchar_t)(0xDC00 | (c & 0x3FF));
+		} else {
+			dst += (wchar_t)c;
+		}
+		p = semicolon + 1;
+	}
+}
+
+const std::wstring* CXmlSaxParser::FindAttribute(const Attributes& attribs, const wchar_t* name)
+{
+	for (const auto& attrib : attribs) {
+		if (attrib.name == name) {
+			return &attrib.value;
+		}
+	}
+	return nullptr;
+}
+
+// strips the namespace prefix, "tt:p" -> "p"
+std::wstring CXmlSaxParser::LocalName(const std::wstring& name)
+{
+	const size_t colon = name.find(L':');
+	return colon == std::wstring::npos ? name : name.substr(colon + 1);
+}
@@ -0,0 +1,78 @@
+/*
+ * (C) 2026 see Authors.txt
+ *
+ * This file is part of MPC-BE.
+ *
+ * MPC-BE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MPC-BE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+//
+// Minimal streaming (SAX-style) XML parser.
+//
+// The document is passed in parts with Parse(), only the incomplete markup or text at
+// the end of a part is kept until the next call. There is no DTD or namespace
+// processing, element and attribute names are reported as they are written.
+// The predefined and numeric character references are resolved, unknown
+// entities are reported literally.
+//
+
+class CXmlSaxParser
+{
+public:
+	struct Attribute {
+		std::wstring name;
+		std::wstring value;
+	};
+	using Attributes = std::vector<Attribute>;
+
+	class Handler
+	{
+	public:
+		virtual ~Handler() = default;
+
+		virtual void StartElement(const std::wstring& name, const Attributes& attribs) = 0;
+		virtual void EndElement(const std::wstring& name) = 0;
+		// the text between two markups in one piece, CDATA sections are reported separately
+		virtual void Characters(const std::wstring& text) = 0;
+	};
+
+	CXmlSaxParser(Handler& handler);
+
+	bool Parse(const wchar_t* data, size_t len);
+	// reports the remaining text and checks that all elements were closed
+	bool Finish();
+
+	static const std::wstring* FindAttribute(const Attributes& attribs, const wchar_t* name);
+	static std::wstring LocalName(const std::wstring& name);
+
+private:
+	Handler&     m_handler;
+	std::wstring m_pending;
+	std::wstring m_name;
+	std::wstring m_text;
+	Attributes   m_attribs;
+	size_t       m_depth  = 0;
+	bool         m_bError = false;
+
+	size_t ParseMarkup(size_t pos);
+	bool ParseStartTag(const wchar_t* p, const wchar_t* end);
+
+	static void AppendDecoded(std::wstring& dst, const wchar_t* p, const wchar_t* end);
+};
@@ -29,6 +29,7 @@
 #include "DSUtil/std_helper.h"
 #include "DSUtil/NullRenderers.h"
 #include "DSUtil/FileHandle.h"
+#include "DSUtil/DiskImageFS.h"
 #include "filters/transform/DeCSSFilter/VobFile.h"
 #include <dmodshow.h>
 #include <evr.h>
@@ -369,8 +370,22 @@ HRESULT CFGManager::EnumSourceFilters(LPCWSTR lpcwstrFileName, CFGFilterList& fl
 
 	HANDLE hFile = INVALID_HANDLE_VALUE;
 	std::vector<BYTE> httpbuf;
+	std::vector<BYTE> imagebuf;
 
-	if ((protocol.GetLength() <= 1 || protocol == L"file" || StartsWith(protocol, EXTENDED_PATH_PREFIX)) && (ext.Compare(L".cda") != 0)) {
+	if ((protocol.GetLength() <= 1 || protocol == L"file" || StartsWith(protocol, EXTENDED_PATH_PREFIX)) && (ext.Compare(L".cda") != 0)
+			&& CDiskImageFS::IsImagePath(fn)) {
+		// file inside a disc image, check the bytes on the beginning of the file
+		CDiskImageFile imageFile;
+		if (!imageFile.Open(fn)) {
+			return VFW_E_NOT_FOUND;
+		}
+		if (!imageFile.GetLength()) {
+			return VFW_E_CANNOT_RENDER;
+		}
+
+		imagebuf.resize((size_t)std::min(imageFile.GetLength(), 64ULL * KILOBYTE));
+		imagebuf.resize(imageFile.Read(imagebuf.data(), (DWORD)imagebuf.size()));
+	} else if ((protocol.GetLength() <= 1 || protocol == L"file" || StartsWith(protocol, EXTENDED_PATH_PREFIX)) && (ext.Compare(L".cda") != 0)) {
 		hFile = CreateFileW(fn, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
 
 		if (hFile == INVALID_HANDLE_VALUE) {
@@ -402,6 +417,18 @@ HRESULT CFGManager::EnumSourceFilters(LPCWSTR lpcwstrFileName, CFGFilterList& fl
 				}
 			}
 
+			// check bytes for a file inside a disc image
+			if (imagebuf.size()) {
+				for (const auto& pFGF : m_source) {
+					for (const auto& bytestring : pFGF->m_chkbytes) {
+						if (CheckBytes(imagebuf.data(), imagebuf.size(), bytestring)) {
+							fl.Insert(pFGF, 1, false, false);
+							break;
+						}
+					}
+				}
+			}
+
 			// protocol
 			for (const auto& pFGF : m_source) {
 				if (Contains(pFGF->m_protocols, protocol)) {
@@ -1,5 +1,5 @@
 /*
- * (C) 2021-2025 see Authors.txt
+ * (C) 2021-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -26,7 +26,7 @@
 // CMpcLstFile
 //
 
-FILE* CMpcLstFile::CheckOpenFileForRead(bool& valid)
+FILE* CMpcLstFile::CheckOpenFileForRead(bool& valid, bool bForce/* = false*/)
 {
 	if (!::PathFileExistsW(m_filename)) {
 		valid = false;
@@ -34,7 +34,7 @@ FILE* CMpcLstFile::CheckOpenFileForRead(bool& valid)
 	}
 
 	const ULONGLONG tick = GetTickCount64();
-	if (m_LastAccessTick && tick - m_LastAccessTick < 100u) {
+	if (!bForce && m_LastAccessTick && tick - m_LastAccessTick < 100u) {
 		valid = true;
 		return nullptr;
 	}
@@ -105,10 +105,60 @@ void CMpcLstFile::SetMaxCount(unsigned maxcount)
 // CSessionFile
 //
 
-bool CSessionFile::ReadFile()
+static void ParseSessionParam(const CStringW& param, const CStringW& value, SessionInfo& sesInfo)
+{
+	if (param == L"Path") {
+		sesInfo.Path = value;
+	}
+	else if (param == L"Position") {
+		int h, m, s;
+		if (swscanf_s(value, L"%02d:%02d:%02d", &h, &m, &s) == 3) {
+			sesInfo.Position = (((h * 60) + m) * 60 + s) * UNITS;
+		}
+	}
+	else if (param == L"DVDId") {
+		StrHexToUInt64(value, sesInfo.DVDId);
+	}
+	else if (param == L"DVDPosition") {
+		unsigned dvdTitle, h, m, s;
+		if (swscanf_s(value, L"%02u,%02u:%02u:%02u", &dvdTitle, &h, &m, &s) == 4) {
+			sesInfo.DVDTitle = dvdTitle;
+			sesInfo.DVDTimecode = { (BYTE)h, (BYTE)m, (BYTE)s, 0 };
+		}
+	}
+	else if (param == L"DVDState") {
+		unsigned ret = Base64ToBynary(value, sesInfo.DVDState);
+		if (!ret) {
+			sesInfo.DVDState.clear();
+		}
+	}
+	else if (param == L"AudioNum") {
+		int32_t i32val;
+		if (StrToInt32(value, i32val) && i32val >= 1) {
+			sesInfo.AudioNum = i32val - 1;
+		}
+	}
+	else if (param == L"SubtitleNum") {
+		int32_t i32val;
+		if (StrToInt32(value, i32val) && i32val >= 1) {
+			sesInfo.SubtitleNum = i32val - 1;
+		}
+	}
+	else if (param == L"AudioPath") {
+		sesInfo.AudioPath = value;
+	}
+	else if (param == L"SubtitlePath") {
+		sesInfo.SubtitlePath = value;
+	}
+	else if (param == L"Title") {
+		sesInfo.Title = value;
+	}
+}
+
+bool CSessionFile::ReadFile(bool bForce/* = false*/)
 {
 	bool valid = false;
-	FILE* pFile = CheckOpenFileForRead(valid);
+	FILE* pFile = CheckOpenFileForRead(valid, bForce);
 	if (!pFile) {
 		return valid;
 	}
@@ -147,52 +197,7 @@ bool CSessionFile::ReadFile()
 			CStringW param = line.Mid(0, pos).Trim();
 			CStringW value = line.Mid(pos + 1).Trim();
 			if (value.GetLength()) {
-				if (param == L"Path") {
-					sesInfo.Path = value;
-				}
-				else if (param == L"Position") {
-					int h, m, s;
-					if (swscanf_s(value, L"%02d:%02d:%02d", &h, &m, &s) == 3) {
-						sesInfo.Position = (((h * 60) + m) * 60 + s) * UNITS;
-					}
-				}
-				else if (param == L"DVDId") {
-					StrHexToUInt64(value, sesInfo.DVDId);
-				}
-				else if (param == L"DVDPosition") {
-					unsigned dvdTitle, h, m, s;
-					if (swscanf_s(value, L"%02u,%02u:%02u:%02u", &dvdTitle, &h, &m, &s) == 4) {
-						sesInfo.DVDTitle = dvdTitle;
-						sesInfo.DVDTimecode = { (BYTE)h, (BYTE)m, (BYTE)s, 0 };
-					}
-				}
-				else if (param == L"DVDState") {
-					unsigned ret = Base64ToBynary(value, sesInfo.DVDState);
-					if (!ret) {
-						sesInfo.DVDState.clear();
-					}
-				}
-				else if (param == L"AudioNum") {
-					int32_t i32val;
-					if (StrToInt32(value, i32val) && i32val >= 1) {
-						sesInfo.AudioNum = i32val - 1;
-					}
-				}
-				else if (param == L"SubtitleNum") {
-					int32_t i32val;
-					if (StrToInt32(value, i32val) && i32val >= 1) {
-						sesInfo.SubtitleNum = i32val - 1;
-					}
-				}
-				else if (param == L"AudioPath") {
-					sesInfo.AudioPath = value;
-				}
-				else if (param == L"SubtitlePath") {
-					sesInfo.SubtitlePath = value;
-				}
-				else if (param == L"Title") {
-					sesInfo.Title = value;
-				}
+				ParseSessionParam(param, value, sesInfo);
 			}
 		}
 	}
@@ -210,32 +215,119 @@ bool CSessionFile::ReadFile()
 // CHistoryFile
 //
 
+#define JOURNAL_MAX_RECORDS 64 // the journal is merged into the history file after this number of records
+
+// Serializes the journal appends and the rewrites of the history file between the running instances,
+// a record appended while another instance merges the journal would be lost otherwise.
+class CHistoryFileLock
+{
+	HANDLE m_hMutex = nullptr;
+
+public:
+	CHistoryFileLock(const CStringW& filename) {
+		CStringW name;
+		name.Format(L"MPC-BE_History_%016I64x", (UINT64)std::hash<std::wstring>()(CStringW(filename).MakeLower().GetString()));
+
+		m_hMutex = CreateMutexW(nullptr, FALSE, name);
+		if (m_hMutex) {
+			const DWORD ret = WaitForSingleObject(m_hMutex, 5000);
+			if (ret != WAIT_OBJECT_0 && ret != WAIT_ABANDONED) {
+				CloseHandle(m_hMutex);
+				m_hMutex = nullptr;
+			}
+		}
+	}
+
+	~CHistoryFileLock() {
+		if (m_hMutex) {
+			ReleaseMutex(m_hMutex);
+			CloseHandle(m_hMutex);
+		}
+	}
+};
+
+static void FormatSessionInfo(CStringW& str, const SessionInfo& sesInfo)
+{
+	str.AppendFormat(L"Path=%s\n", sesInfo.Path);
+
+	if (sesInfo.Title.GetLength()) {
+		str.AppendFormat(L"Title=%s\n", sesInfo.Title);
+	}
+
+	if (sesInfo.DVDId) {
+		str.AppendFormat(L"DVDId=%016I64x\n", sesInfo.DVDId);
+		if (sesInfo.DVDTitle) {
+			str.AppendFormat(L"DVDPosition=%02u,%02u:%02u:%02u\n",
+				(unsigned)sesInfo.DVDTitle,
+				(unsigned)sesInfo.DVDTimecode.bHours,
+				(unsigned)sesInfo.DVDTimecode.bMinutes,
+				(unsigned)sesInfo.DVDTimecode.bSeconds);
+		}
+		if (sesInfo.DVDState.size()) {
+			CStringW base64 = BynaryToBase64W(sesInfo.DVDState.data(), sesInfo.DVDState.size());
+			if (base64.GetLength()) {
+				str.AppendFormat(L"DVDState=%s\n", base64);
+			}
+		}
+	}
+	else {
+		if (sesInfo.Position > UNITS) {
+			LONGLONG seconds = sesInfo.Position / UNITS;
+			int h = (int)(seconds / 3600);
+			int m = (int)(seconds / 60 % 60);
+			int s = (int)(seconds % 60);
+			str.AppendFormat(L"Position=%02d:%02d:%02d\n", h, m, s);
+		}
+		if (sesInfo.AudioNum >= 0) {
+			str.AppendFormat(L"AudioNum=%d\n", sesInfo.AudioNum + 1);
+		}
+		if (sesInfo.SubtitleNum >= 0) {
+			str.AppendFormat(L"SubtitleNum=%d\n", sesInfo.SubtitleNum + 1);
+		}
+		if (sesInfo.AudioPath.GetLength()) {
+			str.AppendFormat(L"AudioPath=%s\n", sesInfo.AudioPath);
+		}
+		if (sesInfo.SubtitlePath.GetLength()) {
+			str.AppendFormat(L"SubtitlePath=%s\n", sesInfo.SubtitlePath);
+		}
+	}
+}
+
+std::wstring CHistoryFile::GetKey(const SessionInfo& sesInfo)
+{
+	if (sesInfo.DVDId) {
+		WCHAR key[24];
+		swprintf_s(key, L"DVD:%016I64x", sesInfo.DVDId);
+		return key;
+	}
+
+	return CStringW(sesInfo.Path).MakeLower().GetString();
+}
+
 void CHistoryFile::IntAddEntry(const SessionInfo& sesInfo)
 {
 	if (sesInfo.Path.GetLength()) {
-		m_SessionInfos.emplace_back(sesInfo);
+		// the first entry wins, unexpected duplicates (for example, after manual editing) are dropped
+		auto key = GetKey(sesInfo);
+		if (m_Index.find(key) == m_Index.end()) {
+			m_SessionInfos.emplace_back(sesInfo);
+			m_Index.emplace(std::move(key), std::prev(m_SessionInfos.end()));
+		}
 	}
 }
 
 void CHistoryFile::IntClearEntries()
 {
 	m_SessionInfos.clear();
+	m_Index.clear();
 }
 
-std::list<SessionInfo>::iterator CHistoryFile::FindSessionInfo(const SessionInfo& sesInfo, std::list<SessionInfo>::iterator begin)
+std::list<SessionInfo>::iterator CHistoryFile::FindSessionInfo(const SessionInfo& sesInfo)
 {
-	if (sesInfo.DVDId) {
-		for (auto it = begin; it != m_SessionInfos.end(); ++it) {
-			if (sesInfo.DVDId == (*it).DVDId) {
-				return it;
-			}
-		}
-	}
-	else if (sesInfo.Path.GetLength()) {
-		for (auto it = begin; it != m_SessionInfos.end(); ++it) {
-			if (sesInfo.Path.CompareNoCase((*it).Path) == 0) {
-				return it;
-			}
+	if (sesInfo.DVDId || sesInfo.Path.GetLength()) {
+		const auto it = m_Index.find(GetKey(sesInfo));
+		if (it != m_Index.end()) {
+			return it->second;
 		}
 	}
 	else {
@@ -245,6 +337,214 @@ std::list<SessionInfo>::iterator CHistoryFile::FindSessionInfo(const SessionInfo
 	return m_SessionInfos.end();
 }
 
+void CHistoryFile::MoveToFront(const SessionInfo& sesInfo)
+{
+	if (sesInfo.Path.IsEmpty()) {
+		return;
+	}
+
+	auto key = GetKey(sesInfo);
+	const auto it = m_Index.find(key);
+	if (it != m_Index.end()) {
+		m_SessionInfos.erase(it->second);
+		m_Index.erase(it);
+	}
+
+	m_SessionInfos.emplace_front(sesInfo);
+	m_Index.emplace(std::move(key), m_SessionInfos.begin());
+
+	TrimEntries();
+}
+
+void CHistoryFile::TrimEntries()
+{
+	while (m_SessionInfos.size() > m_maxCount) {
+		m_Index.erase(GetKey(m_SessionInfos.back()));
+		m_SessionInfos.pop_back();
+	}
+}
+
+bool CHistoryFile::SyncFile()
+{
+	ULONGLONG fileSize = 0;
+	ULONGLONG fileTime = 0;
+
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	if (GetFileAttributesExW(m_filename, GetFileExInfoStandard, &fad)) {
+		fileSize = ((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+		fileTime = ((ULONGLONG)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime;
+	}
+
+	if (!m_bLoaded || fileSize != m_FileSize || fileTime != m_FileTime) {
+		// the file was rewritten (by us before the start or by another instance), reload it completely
+		IntClearEntries();
+		if (fileTime && !ReadFile(true)) {
+			return false;
+		}
+
+		m_bLoaded        = true;
+		m_FileSize       = fileSize;
+		m_FileTime       = fileTime;
+		m_JournalPos     = 0;
+		m_JournalRecords = 0;
+	}
+
+	return ReadJournal();
+}
+
+bool CHistoryFile::ReadJournal()
+{
+	HANDLE hFile = CreateFileW(GetJournalFilename(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		m_JournalPos = 0;
+		m_JournalRecords = 0;
+		return true;
+	}
+
+	LARGE_INTEGER size = {};
+	GetFileSizeEx(hFile, &size);
+	if ((ULONGLONG)size.QuadPart < m_JournalPos) {
+		// the journal was recreated, apply it from the beginning
+		m_JournalPos = 0;
+		m_JournalRecords = 0;
+	}
+
+	std::vector<char> data;
+	if ((ULONGLONG)size.QuadPart > m_JournalPos) {
+		data.resize((size_t)(size.QuadPart - m_JournalPos));
+
+		LARGE_INTEGER pos;
+		pos.QuadPart = m_JournalPos;
+		DWORD read = 0;
+		if (!SetFilePointerEx(hFile, pos, nullptr, FILE_BEGIN) || !::ReadFile(hFile, data.data(), (DWORD)data.size(), &read, nullptr)) {
+			read = 0;
+		}
+		data.resize(read);
+	}
+	CloseHandle(hFile);
+
+	// use only complete lines, a record can be being written now
+	while (data.size() && data.back() != '\n') {
+		data.pop_back();
+	}
+	if (data.empty()) {
+		return true;
+	}
+	m_JournalPos += data.size();
+	data.push_back('\0');
+
+	std::list<CStringW> lines;
+	Explode(UTF8ToWStr(data.data()), lines, L'\n');
+
+	SessionInfo sesInfo;
+	bool bRecord = false;
+
+	for (auto& line : lines) {
+		line.Trim();
+
+		if (line.IsEmpty() || line[0] == ';') {
+			continue;
+		}
+
+		if (line[0] == '[') { // new record
+			if (bRecord) {
+				MoveToFront(sesInfo);
+				m_JournalRecords++;
+			}
+			sesInfo = {};
+			bRecord = true;
+			continue;
+		}
+
+		const int pos = line.Find('=');
+		if (bRecord && pos > 0 && pos + 1 < line.GetLength()) {
+			CStringW param = line.Mid(0, pos).Trim();
+			CStringW value = line.Mid(pos + 1).Trim();
+			if (value.GetLength()) {
+				ParseSessionParam(param, value, sesInfo);
+			}
+		}
+	}
+
+	if (bRecord) {
+		MoveToFront(sesInfo);
+		m_JournalRecords++;
+	}
+
+	return true;
+}
+
+bool CHistoryFile::AppendJournal(const SessionInfo& sesInfo)
+{
+	if (m_JournalRecords + 1 >= JOURNAL_MAX_RECORDS) {
+		return Compact(&sesInfo);
+	}
+
+	CStringW str(L"\n[+]\n");
+	FormatSessionInfo(str, sesInfo);
+	const CStringA utf8 = WStrToUTF8(str);
+
+	CHistoryFileLock fileLock(m_filename);
+
+	HANDLE hFile = CreateFileW(GetJournalFilename(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return Compact(&sesInfo);
+	}
+
+	DWORD written = 0;
+	const BOOL ret = ::WriteFile(hFile, utf8.GetString(), utf8.GetLength(), &written, nullptr);
+
+	LARGE_INTEGER size = {};
+	GetFileSizeEx(hFile, &size);
+	CloseHandle(hFile);
+
+	if (!ret || written != (DWORD)utf8.GetLength()) {
+		return Compact(&sesInfo);
+	}
+
+	// if another instance has written to the journal meanwhile, its records will be applied on the next synchronization
+	if ((ULONGLONG)size.QuadPart == m_JournalPos + written) {
+		m_JournalPos += written;
+	}
+	m_JournalRecords++;
+
+	return true;
+}
+
+bool CHistoryFile::Compact(const SessionInfo* pSesInfo/* = nullptr*/)
+{
+	CHistoryFileLock fileLock(m_filename);
+
+	// the records appended by the other instances since the last synchronization are merged too
+	if (!SyncFile()) {
+		return false;
+	}
+	if (pSesInfo) {
+		MoveToFront(*pSesInfo);
+	}
+
+	return IntCompact();
+}
+
+bool CHistoryFile::IntCompact()
+{
+	if (!WriteFile()) {
+		return false;
+	}
+
+	_wremove(GetJournalFilename());
+	m_JournalPos = 0;
+	m_JournalRecords = 0;
+
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	if (GetFileAttributesExW(m_filename, GetFileExInfoStandard, &fad)) {
+		m_FileSize = ((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+		m_FileTime = ((ULONGLONG)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime;
+	}
+
+	return true;
+}
+
 bool CHistoryFile::WriteFile()
 {
 	FILE* pFile = OpenFileForWrite();
@@ -262,50 +562,7 @@ bool CHistoryFile::WriteFile()
 		for (const auto& sesInfo : m_SessionInfos) {
 			if (sesInfo.Path.GetLength()) {
 				str.Format(L"\n[%03d]\n", i++);
-
-				str.AppendFormat(L"Path=%s\n", sesInfo.Path);
-
-				if (sesInfo.Title.GetLength()) {
-					str.AppendFormat(L"Title=%s\n", sesInfo.Title);
-				}
-
-				if (sesInfo.DVDId) {
-					str.AppendFormat(L"DVDId=%016I64x\n", sesInfo.DVDId);
-					if (sesInfo.DVDTitle) {
-						str.AppendFormat(L"DVDPosition=%02u,%02u:%02u:%02u\n",
-							(unsigned)sesInfo.DVDTitle,
-							(unsigned)sesInfo.DVDTimecode.bHours,
-							(unsigned)sesInfo.DVDTimecode.bMinutes,
-							(unsigned)sesInfo.DVDTimecode.bSeconds);
-					}
-					if (sesInfo.DVDState.size()) {
-						CStringW base64 = BynaryToBase64W(sesInfo.DVDState.data(), sesInfo.DVDState.size());
-						if (base64.GetLength()) {
-							str.AppendFormat(L"DVDState=%s\n", base64);
-						}
-					}
-				}
-				else {
-					if (sesInfo.Position > UNITS) {
-						LONGLONG seconds = sesInfo.Position / UNITS;
-						int h = (int)(seconds / 3600);
-						int m = (int)(seconds / 60 % 60);
-						int s = (int)(seconds % 60);
-						str.AppendFormat(L"Position=%02d:%02d:%02d\n", h, m, s);
-					}
-					if (sesInfo.AudioNum >= 0) {
-						str.AppendFormat(L"AudioNum=%d\n", sesInfo.AudioNum + 1);
-					}
-					if (sesInfo.SubtitleNum >= 0) {
-						str.AppendFormat(L"SubtitleNum=%d\n", sesInfo.SubtitleNum + 1);
-					}
-					if (sesInfo.AudioPath.GetLength()) {
-						str.AppendFormat(L"AudioPath=%s\n", sesInfo.AudioPath);
-					}
-					if (sesInfo.SubtitlePath.GetLength()) {
-						str.AppendFormat(L"SubtitlePath=%s\n", sesInfo.SubtitlePath);
-					}
-				}
+				FormatSessionInfo(str, sesInfo);
 				file.WriteString(str);
 			}
 		}
@@ -322,14 +579,42 @@ bool CHistoryFile::WriteFile()
 	return ret;
 }
 
+bool CHistoryFile::Clear()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		_wremove(GetJournalFilename());
+		m_bLoaded = false;
+	}
+
+	return CMpcLstFile::Clear();
+}
+
+void CHistoryFile::SetFilename(const CStringW& filename)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_filename.GetLength() && m_filename.CompareNoCase(filename) != 0) {
+		// merge the journal into the old file, it can be moved after that
+		if (::PathFileExistsW(GetJournalFilename())) {
+			Compact();
+		}
+		IntClearEntries();
+		m_bLoaded = false;
+	}
+
+	m_filename = filename;
+}
+
 bool CHistoryFile::OpenSessionInfo(SessionInfo& sesInfo, bool bReadPos)
 {
 	std::lock_guard<std::mutex> lock(m_Mutex);
 
-	ReadFile();
+	SyncFile();
 
 	bool found = false;
-	auto it = FindSessionInfo(sesInfo, m_SessionInfos.begin());
+	auto it = FindSessionInfo(sesInfo);
 
 	if (it != m_SessionInfos.end()) {
 		found = true;
@@ -356,16 +641,8 @@ bool CHistoryFile::OpenSessionInfo(SessionInfo& sesInfo, bool bReadPos)
 	}
 
 	if (it != m_SessionInfos.begin() || !found) { // not first entry or empty list
-		if (found) {
-			m_SessionInfos.erase(it);
-		}
-
-		m_SessionInfos.emplace_front(sesInfo);
-
-		while (m_SessionInfos.size() > m_maxCount) {
-			m_SessionInfos.pop_back();
-		}
-		WriteFile();
+		MoveToFront(sesInfo);
+		AppendJournal(sesInfo);
 	}
 
 	return found;
@@ -375,52 +652,51 @@ void CHistoryFile::SaveSessionInfo(const SessionInfo& sesInfo)
 {
 	std::lock_guard<std::mutex> lock(m_Mutex);
 
-	ReadFile();
+	SyncFile();
 
 	if (m_SessionInfos.size()) {
-		auto it = FindSessionInfo(sesInfo, m_SessionInfos.begin());
+		auto it = FindSessionInfo(sesInfo);
 
 		if (it == m_SessionInfos.begin() && sesInfo.Equals(*it)) {
 			return;
 		}
-
-		if (it != m_SessionInfos.end()) {
-			m_SessionInfos.erase(it);
-		}
 	}
 
-	m_SessionInfos.emplace_front(sesInfo); // Writing new data
-
-	while (m_SessionInfos.size() > m_maxCount) {
-		m_SessionInfos.pop_back();
-	}
-
-	WriteFile();
+	MoveToFront(sesInfo); // Writing new data
+	AppendJournal(sesInfo);
 }
 
 bool CHistoryFile::DeleteSessions(const std::list<SessionInfo>& sessions)
 {
 	std::lock_guard<std::mutex> lock(m_Mutex);
+	CHistoryFileLock fileLock(m_filename);
 
-	if (!ReadFile()) {
+	if (!SyncFile()) {
 		return false;
 	}
 
 	bool changed = false;
 
 	for (const auto& sesInfo : sessions) {
-		auto it = FindSessionInfo(sesInfo, m_SessionInfos.begin());
-
-		// delete what was found and all unexpected duplicates (for example, after manual editing)
-		while (it != m_SessionInfos.end()) {
-			m_SessionInfos.erase(it++);
-			changed = true;
-			it = FindSessionInfo(sesInfo, it);
+		// delete what was found and all unexpected duplicates (for example, a DVD entry with the same path)
+		for (auto it = m_SessionInfos.begin(); it != m_SessionInfos.end();) {
+			const bool match = sesInfo.DVDId ? sesInfo.DVDId == (*it).DVDId
+								: sesInfo.Path.GetLength() && sesInfo.Path.CompareNoCase((*it).Path) == 0;
+			if (match) {
+				const auto index = m_Index.find(GetKey(*it));
+				if (index != m_Index.end() && index->second == it) {
+					m_Index.erase(index);
+				}
+				it = m_SessionInfos.erase(it);
+				changed = true;
+			} else {
+				++it;
+			}
 		}
 	}
 
 	if (changed) {
-		return WriteFile();
+		return IntCompact();
 	}
 
 	return true; // already deleted
@@ -431,7 +707,7 @@ void CHistoryFile::GetRecentPaths(std::vector<CStringW>& recentPaths, unsigned c
 	std::lock_guard<std::mutex> lock(m_Mutex);
 
 	recentPaths.clear();
-	ReadFile();
+	SyncFile();
 
 	if (count > m_SessionInfos.size()) {
 		count = m_SessionInfos.size();
@@ -451,7 +727,7 @@ void CHistoryFile::GetRecentSessions(std::vector<SessionInfo>& recentSessions, u
 	std::lock_guard<std::mutex> lock(m_Mutex);
 
 	recentSessions.clear();
-	ReadFile();
+	SyncFile();
 
 	if (count > m_SessionInfos.size()) {
 		count = m_SessionInfos.size();
@@ -469,7 +745,7 @@ void CHistoryFile::GetRecentSessions(std::vector<SessionInfo>& recentSessions, u
 unsigned CHistoryFile::GetSessionsCount()
 {
 	std::lock_guard<std::mutex> lock(m_Mutex);
-	ReadFile();
+	SyncFile();
 
 	return m_SessionInfos.size();
 }
@@ -477,16 +753,14 @@ unsigned CHistoryFile::GetSessionsCount()
 void CHistoryFile::TrunkFile(unsigned maxcount)
 {
 	std::lock_guard<std::mutex> lock(m_Mutex);
+	CHistoryFileLock fileLock(m_filename);
 
-	ReadFile();
+	SyncFile();
 
 	SetMaxCount(maxcount);
+	TrimEntries();
 
-	while (m_SessionInfos.size() > m_maxCount) {
-		m_SessionInfos.pop_back();
-	}
-
-	WriteFile();
+	IntCompact();
 }
 
 //
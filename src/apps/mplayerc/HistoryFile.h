@@ -1,5 +1,5 @@
 /*
- * (C) 2021-2024 see Authors.txt
+ * (C) 2021-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <unordered_map>
+
 struct SessionInfo {
 	CStringW Path;
 	CStringW Title;
@@ -81,7 +83,7 @@ protected:
 	CStringW m_filename;
 	unsigned m_maxCount = 100;
 
-	FILE* CheckOpenFileForRead(bool& valid);
+	FILE* CheckOpenFileForRead(bool& valid, bool bForce = false);
 	FILE* OpenFileForWrite();
 	void CloseFile(FILE*& pFile);
 
@@ -102,7 +104,7 @@ class CSessionFile : public CMpcLstFile
 {
 protected:
 	virtual void IntAddEntry(const SessionInfo& sesInfo) = 0;
-	bool ReadFile();
+	bool ReadFile(bool bForce = false);
 };
 
 //
@@ -112,15 +114,39 @@ protected:
 class CHistoryFile : public CSessionFile
 {
 private:
+	// entries in the order of recent use and an index by the session key (DVD id or path)
 	std::list<SessionInfo> m_SessionInfos;
+	std::unordered_map<std::wstring, std::list<SessionInfo>::iterator> m_Index;
+
+	// changes since the last full write are appended to "<filename>.journal"
+	bool      m_bLoaded = false;
+	ULONGLONG m_FileSize = 0;
+	ULONGLONG m_FileTime = 0;
+	ULONGLONG m_JournalPos = 0; // already applied part of the journal
+	unsigned  m_JournalRecords = 0;
+
+	static std::wstring GetKey(const SessionInfo& sesInfo);
+	CStringW GetJournalFilename() const { return m_filename + L".journal"; }
 
 	void IntAddEntry(const SessionInfo& sesInfo) override;
 	void IntClearEntries() override;
 
-	std::list<SessionInfo>::iterator FindSessionInfo(const SessionInfo& sesInfo, std::list<SessionInfo>::iterator begin);
+	std::list<SessionInfo>::iterator FindSessionInfo(const SessionInfo& sesInfo);
+	void MoveToFront(const SessionInfo& sesInfo);
+	void TrimEntries();
+
+	bool SyncFile(); // reload the file if it was changed and apply new journal records
+	bool ReadJournal();
+	bool AppendJournal(const SessionInfo& sesInfo);
+	// synchronize, apply the change that is not in the journal yet, write all entries to the file and remove the journal
+	bool Compact(const SessionInfo* pSesInfo = nullptr);
+	bool IntCompact(); // the caller holds the file lock and has synchronized the entries
 	bool WriteFile();
 
 public:
+	bool Clear();
+	void SetFilename(const CStringW& filename) override;
+
 	bool OpenSessionInfo(SessionInfo& sesInfo, bool bReadPos); // Read or create an entry in the history file
 	void SaveSessionInfo(const SessionInfo& sesInfo);
 	bool DeleteSessions(const std::list<SessionInfo>& sessions);
@@ -32,6 +32,7 @@
 #include "DSUtil/std_helper.h"
 #include "DSUtil/UrlParser.h"
 #include "DSUtil/NullRenderers.h"
+#include "DSUtil/DiskImageFS.h"
 #include "OpenDlg.h"
 #include "SaveTaskDlg.h"
 #include "GoToDlg.h"
@@ -19504,7 +19505,12 @@ BOOL CMainFrame::OpenBD(const CString& path, REFERENCE_TIME rtStart, BOOL bAddRe
 		return FALSE;
 	}
 
-	if (::PathIsDirectoryW(bdmv_folder + L"\\PLAYLIST") && ::PathIsDirectoryW(bdmv_folder + L"\\STREAM")) {
+	const bool bImage = CDiskImageFS::IsImagePath(bdmv_folder);
+	const bool bValidFolder = bImage
+		? CDiskImageFS::DirectoryExists(bdmv_folder + L"\\PLAYLIST") && CDiskImageFS::DirectoryExists(bdmv_folder + L"\\STREAM")
+		: ::PathIsDirectoryW(bdmv_folder + L"\\PLAYLIST") && ::PathIsDirectoryW(bdmv_folder + L"\\STREAM");
+
+	if (bValidFolder) {
 		CHdmvClipInfo ClipInfo;
 		CString main_mpls_file;
 		CHdmvClipInfo::CPlaylist Playlist;
@@ -20352,6 +20358,13 @@ BOOL CMainFrame::OpenIso(const CString& pathName, REFERENCE_TIME rtStart/* = INV
 	if (m_DiskImage.CheckExtension(pathName)) {
 		SendMessageW(WM_COMMAND, ID_FILE_CLOSEMEDIA);
 
+		// Blu-ray images are read directly, without mounting
+		if (CDiskImageFS::FileExists(pathName + L"\\BDMV\\index.bdmv")
+				&& OpenBD(pathName + L"\\BDMV\\index.bdmv", rtStart, FALSE)) {
+			AddRecent(pathName);
+			return TRUE;
+		}
+
 		WCHAR diskletter = m_DiskImage.MountDiskImage(pathName);
 		if (diskletter) {
 			if (::PathFileExistsW(CString(diskletter) + L":\\BDMV\\index.bdmv")) {
@@ -515,17 +515,9 @@ POSITION CPlaylist::Append(CPlaylistItem& item, const bool bParseDuration)
 {
 	if (bParseDuration && !item.m_duration && item.m_fi.Valid()) {
 		const auto& fn = item.m_fi.GetPath();
-		if (!::PathIsURLW(item.m_fi) && ::PathFileExistsW(item.m_fi)) {
-			MediaInfoLib::MediaInfo MI;
-			MI.Option(L"ParseSpeed", L"0");
-			if (MI.Open(fn.GetString())) {
-				using namespace MediaInfoLib;
-
-				String duration = MI.Get(Stream_General, 0, L"Duration", Info_Text, Info_Name);
-				if (!duration.empty() && StrToInt64(duration.c_str(), item.m_duration)) {
-					item.m_duration *= 10000LL;
-				}
-			}
+		if (!::PathIsURLW(fn)) {
+			// takes the duration from the cache or probes the file in the background, see CPlayerPlaylistBar::OnPlaylistDuration()
+			s_DurationProber.GetDuration(item.m_id, fn, item.m_duration);
 		}
 	}
 
@@ -789,6 +781,8 @@ CPlayerPlaylistBar::CPlayerPlaylistBar(CMainFrame* pMainFrame)
 
 CPlayerPlaylistBar::~CPlayerPlaylistBar()
 {
+	CPlaylist::s_DurationProber.Stop();
+
 	TEnsureVisible(m_nCurPlayListIndex); // save selected tab visible
 	TSaveSettings();
 
@@ -803,6 +797,12 @@ BOOL CPlayerPlaylistBar::Create(CWnd* pParentWnd, UINT defDockBarID)
 		return FALSE;
 	}
 
+	CStringW cacheFilename;
+	if (AfxGetMyApp()->GetAppSavePath(cacheFilename)) {
+		cacheFilename.Append(L"durations.mpc_cache");
+	}
+	CPlaylist::s_DurationProber.Init(m_hWnd, cacheFilename);
+
 	m_list.CreateEx(
 		0, //less margins//WS_EX_DLGMODALFRAME | WS_EX_CLIENTEDGE,
 		WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN | WS_TABSTOP
@@ -2830,6 +2830,7 @@ BEGIN_MESSAGE_MAP(CPlayerPlaylistBar, CSizingControlBarG)
 	ON_WM_LBUTTONUP()
 	ON_NOTIFY_EX_RANGE(TTN_NEEDTEXTW, 0, 0xFFFF, OnToolTipNotify)
 	ON_WM_TIMER()
+	ON_MESSAGE(WM_PLAYLIST_DURATION, OnPlaylistDuration)
 	ON_WM_CONTEXTMENU()
 	ON_NOTIFY(LVN_BEGINLABELEDITW, IDC_PLAYLIST, OnLvnBeginlabeleditList)
 	ON_NOTIFY(LVN_ENDLABELEDITW, IDC_PLAYLIST, OnLvnEndlabeleditList)
@@ -3288,6 +3289,42 @@ void CPlayerPlaylistBar::OnTimer(UINT_PTR nIDEvent)
 	__super::OnTimer(nIDEvent);
 }
 
+LRESULT CPlayerPlaylistBar::OnPlaylistDuration(WPARAM wParam, LPARAM lParam)
+{
+	std::vector<std::pair<UINT, REFERENCE_TIME>> results;
+	CPlaylist::s_DurationProber.GetResults(results);
+	if (results.empty()) {
+		return 0;
+	}
+
+	std::map<UINT, REFERENCE_TIME> durations(results.cbegin(), results.cend());
+
+	for (size_t i = 0; i < m_pls.size() && durations.size(); i++) {
+		if (m_tabs[i].type != PL_BASIC) {
+			continue;
+		}
+
+		auto& pl = *m_pls[i];
+		POSITION pos = pl.GetHeadPosition();
+		for (int index = 0; pos && durations.size(); index++) {
+			auto& pli = pl.GetNext(pos);
+
+			const auto it = durations.find(pli.m_id);
+			if (it != durations.end()) {
+				if (!pli.m_duration) {
+					pli.m_duration = it->second;
+					if (i == m_nCurPlayListIndex && index < m_list.GetItemCount()) {
+						m_list.SetItemText(index, COL_TIME, pli.GetLabel(1));
+					}
+				}
+				durations.erase(it);
+			}
+		}
+	}
+
+	return 0;
+}
+
 void CPlayerPlaylistBar::OnLButtonDblClk(UINT nFlags, CPoint point)
 {
 	CRect rcBar;
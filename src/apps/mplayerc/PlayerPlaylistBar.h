@@ -25,6 +25,7 @@
 #include "PlayerListCtrl.h"
 #include "controls/ColorEdit.h"
 #include "FileItem.h"
+#include "PlaylistDuration.h"
 
 class CPlaylistItem
 {
@@ -82,6 +83,8 @@ public:
 	CPlaylist() = default;
 	~CPlaylist() = default;
 
+	static inline CPlaylistDurationProber s_DurationProber;
+
 	POSITION Append(CPlaylistItem& item, const bool bParseDuration);
 
 	bool RemoveAll();
@@ -418,6 +421,7 @@ public:
 	afx_msg void OnLButtonUp(UINT nFlags, CPoint point);
 	afx_msg BOOL OnToolTipNotify(UINT id, NMHDR* pNMHDR, LRESULT* pResult);
 	afx_msg void OnTimer(UINT_PTR nIDEvent);
+	afx_msg LRESULT OnPlaylistDuration(WPARAM wParam, LPARAM lParam);
 	afx_msg void OnContextMenu(CWnd* /*pWnd*/, CPoint /*point*/);
 	afx_msg void OnLvnBeginlabeleditList(NMHDR* pNMHDR, LRESULT* pResult);
 	afx_msg void OnLvnEndlabeleditList(NMHDR* pNMHDR, LRESULT* pResult);
@@ -0,0 +1,272 @@
+/*
+ * (C) 2026 see Authors.txt
+ *
+ * This file is part of MPC-BE.
+ *
+ * MPC-BE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MPC-BE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "stdafx.h"
+#include <MediaInfo/MediaInfo.h>
+#include "PlaylistDuration.h"
+
+#define MAX_PROBE_THREADS    4
+#define MAX_CACHE_ENTRIES    65536
+#define SAVE_CACHE_INTERVAL  256  // new entries
+#define STOP_TIMEOUT_MS      1000
+
+static std::wstring GetCacheKey(const CStringW& path)
+{
+	return CStringW(path).MakeLower().GetString();
+}
+
+//
+// CPlaylistDurationProber
+//
+
+CPlaylistDurationProber::~CPlaylistDurationProber()
+{
+	Stop();
+}
+
+void CPlaylistDurationProber::Init(HWND hWnd, const CStringW& cacheFilename)
+{
+	std::unique_lock<std::mutex> lock(m_pState->mutex);
+
+	m_pState->hNotifyWnd = hWnd;
+	m_pState->cacheFilename = cacheFilename;
+}
+
+void CPlaylistDurationProber::Stop()
+{
+	auto& state = *m_pState;
+
+	std::unique_lock<std::mutex> lock(state.mutex);
+
+	state.bStop = true;
+	state.hNotifyWnd = nullptr;
+	state.requests.clear();
+	state.results.clear();
+	state.cv.notify_all();
+
+	// MediaInfo can't be cancelled, workers still probing after the timeout are left to finish on their own
+	if (!state.cvExit.wait_for(lock, std::chrono::milliseconds(STOP_TIMEOUT_MS), [&] { return state.nThreads == 0; })) {
+		DLog(L"CPlaylistDurationProber::Stop() : %Iu workers are still probing", state.nThreads);
+	}
+
+	lock.unlock();
+	SaveCache(state);
+
+	const CStringW cacheFilename = state.cacheFilename;
+	m_pState = std::make_shared<state_t>();
+	m_pState->cacheFilename = cacheFilename;
+}
+
+bool CPlaylistDurationProber::GetDuration(UINT id, const CStringW& path, REFERENCE_TIME& duration)
+{
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	if (!GetFileAttributesExW(path, GetFileExInfoStandard, &fad)) {
+		return false;
+	}
+
+	request_t request = {
+		id,
+		path,
+		((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow,
+		((ULONGLONG)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime
+	};
+
+	auto& state = *m_pState;
+
+	std::unique_lock<std::mutex> lock(state.mutex);
+
+	if (!state.bCacheLoaded) {
+		LoadCache(state);
+	}
+
+	const auto it = state.cache.find(GetCacheKey(path));
+	if (it != state.cache.end() && it->second.size == request.size && it->second.mtime == request.mtime) {
+		duration = it->second.duration;
+		return true;
+	}
+
+	if (state.bStop) {
+		return false;
+	}
+
+	state.requests.emplace_back(std::move(request));
+
+	const size_t maxThreads = std::clamp(std::thread::hardware_concurrency(), 1u, (unsigned)MAX_PROBE_THREADS);
+	if (state.nThreads < maxThreads && state.nThreads < state.requests.size()) {
+		std::thread(&CPlaylistDurationProber::WorkerThread, m_pState).detach();
+		state.nThreads++;
+	}
+
+	lock.unlock();
+	state.cv.notify_one();
+
+	return false;
+}
+
+void CPlaylistDurationProber::GetResults(std::vector<std::pair<UINT, REFERENCE_TIME>>& results)
+{
+	std::unique_lock<std::mutex> lock(m_pState->mutex);
+
+	results.clear();
+	std::swap(results, m_pState->results);
+}
+
+void CPlaylistDurationProber::WorkerThread(std::shared_ptr<state_t> pState)
+{
+	auto& state = *pState;
+
+	for (;;) {
+		std::unique_lock<std::mutex> lock(state.mutex);
+		state.cv.wait(lock, [&] { return state.bStop || !state.requests.empty(); });
+		if (state.bStop) {
+			break;
+		}
+
+		const request_t request = std::move(state.requests.front());
+		state.requests.pop_front();
+		lock.unlock();
+
+		REFERENCE_TIME duration = 0;
+
+		MediaInfoLib::MediaInfo MI;
+		MI.Option(L"ParseSpeed", L"0");
+		if (MI.Open(request.path.GetString())) {
+			using namespace MediaInfoLib;
+
+			String str = MI.Get(Stream_General, 0, L"Duration", Info_Text, Info_Name);
+			if (!str.empty() && StrToInt64(str.c_str(), duration)) {
+				duration *= 10000LL;
+			}
+		}
+
+		lock.lock();
+
+		if (state.bStop) {
+			break;
+		}
+
+		if (state.cache.size() >= MAX_CACHE_ENTRIES) {
+			state.cache.clear();
+		}
+		state.cache[GetCacheKey(request.path)] = { request.size, request.mtime, duration };
+		state.nUnsaved++;
+
+		if (duration && state.hNotifyWnd) {
+			state.results.emplace_back(request.id, duration);
+			if (state.results.size() == 1) {
+				// the window takes all results accumulated until it handles the message
+				PostMessageW(state.hNotifyWnd, WM_PLAYLIST_DURATION, 0, 0);
+			}
+		}
+
+		// save when the queue is done, or periodically during a long scan
+		if (state.requests.empty() || state.nUnsaved >= SAVE_CACHE_INTERVAL) {
+			lock.unlock();
+			SaveCache(state);
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(state.mutex);
+	state.nThreads--;
+	state.cvExit.notify_all();
+}
+
+void CPlaylistDurationProber::LoadCache(state_t& state)
+{
+	state.bCacheLoaded = true;
+
+	if (state.cacheFilename.IsEmpty()) {
+		return;
+	}
+
+	FILE* pFile = nullptr;
+	if (_wfopen_s(&pFile, state.cacheFilename, L"r, ccs=UTF-8") != 0 || !pFile) {
+		return;
+	}
+
+	CStdioFile file(pFile);
+	CStringW line;
+
+	try {
+		// size<TAB>modification time<TAB>duration<TAB>path
+		while (file.ReadString(line)) {
+			if (line.IsEmpty() || line[0] == ';') {
+				continue;
+			}
+
+			std::list<CStringW> fields;
+			Explode(line, fields, L'\t', 4);
+			if (fields.size() != 4) {
+				continue;
+			}
+
+			auto it = fields.cbegin();
+			cache_entry_t entry;
+			entry.size     = wcstoull(*it++, nullptr, 10);
+			entry.mtime    = wcstoull(*it++, nullptr, 10);
+			entry.duration = wcstoll(*it++, nullptr, 10);
+			state.cache[GetCacheKey(*it)] = entry;
+		}
+	}
+	catch (CFileException& e) {
+		UNREFERENCED_PARAMETER(e);
+		state.cache.clear();
+	}
+
+	fclose(pFile);
+}
+
+void CPlaylistDurationProber::SaveCache(state_t& state)
+{
+	// one writer at a time, the entries are copied so that the workers aren't blocked by the file I/O
+	std::unique_lock<std::mutex> lockSave(state.mutexSave);
+
+	std::unique_lock<std::mutex> lock(state.mutex);
+	if (!state.nUnsaved || state.cacheFilename.IsEmpty()) {
+		return;
+	}
+	const CStringW cacheFilename = state.cacheFilename;
+	const auto cache = state.cache;
+	state.nUnsaved = 0;
+	lock.unlock();
+
+	FILE* pFile = nullptr;
+	if (_wfopen_s(&pFile, cacheFilename, L"w, ccs=UTF-8") != 0 || !pFile) {
+		return;
+	}
+
+	CStdioFile file(pFile);
+	CStringW line;
+
+	try {
+		file.WriteString(L"; MPC-BE Duration Cache 0.1\n");
+		for (const auto& [key, entry] : cache) {
+			line.Format(L"%I64u\t%I64u\t%I64d\t%s\n", entry.size, entry.mtime, entry.duration, key.c_str());
+			file.WriteString(line);
+		}
+	}
+	catch (CFileException& e) {
+		// Fail silently if disk is full
+		UNREFERENCED_PARAMETER(e);
+		ASSERT(FALSE);
+	}
+
+	fclose(pFile);
+}
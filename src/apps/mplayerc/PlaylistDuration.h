@@ -0,0 +1,89 @@
+/*
+ * (C) 2026 see Authors.txt
+ *
+ * This file is part of MPC-BE.
+ *
+ * MPC-BE is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MPC-BE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+
+//
+// CPlaylistDurationProber
+//
+// Determines the duration of playlist items with MediaInfo on worker threads.
+// The results are kept in a persistent cache keyed by path, size and modification time.
+//
+
+class CPlaylistDurationProber
+{
+	struct cache_entry_t {
+		ULONGLONG size;
+		ULONGLONG mtime;
+		REFERENCE_TIME duration;
+	};
+
+	struct request_t {
+		UINT id;
+		CStringW path;
+		ULONGLONG size;
+		ULONGLONG mtime;
+	};
+
+	// shared with the workers, a worker blocked in MediaInfo on a slow network path
+	// is left running on Stop() and keeps its state alive until it returns
+	struct state_t {
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::condition_variable cvExit;
+		std::deque<request_t> requests;
+		std::vector<std::pair<UINT, REFERENCE_TIME>> results;
+		size_t nThreads = 0;
+		bool bStop = false;
+
+		HWND hNotifyWnd = nullptr;
+
+		CStringW cacheFilename;
+		std::unordered_map<std::wstring, cache_entry_t> cache;
+		bool bCacheLoaded = false;
+		size_t nUnsaved = 0;
+
+		std::mutex mutexSave;
+	};
+
+	std::shared_ptr<state_t> m_pState = std::make_shared<state_t>();
+
+	static void WorkerThread(std::shared_ptr<state_t> pState);
+	static void LoadCache(state_t& state);
+	static void SaveCache(state_t& state);
+
+public:
+	CPlaylistDurationProber() = default;
+	~CPlaylistDurationProber();
+
+	// hWnd receives WM_PLAYLIST_DURATION when new results are available
+	void Init(HWND hWnd, const CStringW& cacheFilename);
+	void Stop();
+
+	// returns true if the duration is known, otherwise the file is queued for probing
+	bool GetDuration(UINT id, const CStringW& path, REFERENCE_TIME& duration);
+	void GetResults(std::vector<std::pair<UINT, REFERENCE_TIME>>& results);
+};
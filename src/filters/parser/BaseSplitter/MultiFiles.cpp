@@ -53,7 +53,7 @@ BOOL CMultiFiles::OpenFiles(CHdmvClipInfo::CPlaylist& files)
 		}
 
 		llSize.QuadPart = 0;
-		GetFileSizeEx(m_hFile, &llSize);
+		PartSize(&llSize);
 		m_llTotalLength += llSize.QuadPart;
 		m_FilesSize.emplace_back(llSize.QuadPart);
 
@@ -76,9 +76,9 @@ ULONGLONG CMultiFiles::Seek(LONGLONG lOff, UINT nFrom)
 
 	if (m_strFiles.size() == 1) {
 		llOff.QuadPart = lOff;
-		if (!SetFilePointerEx(m_hFile, llOff, &llNewPos, nFrom)) {
+		if (!PartSeek(llOff, &llNewPos, nFrom)) {
 			if (Reopen()) {
-				SetFilePointerEx(m_hFile, llOff, &llNewPos, nFrom);
+				PartSeek(llOff, &llNewPos, nFrom);
 			}
 		}
 
@@ -95,9 +95,9 @@ ULONGLONG CMultiFiles::Seek(LONGLONG lOff, UINT nFrom)
 
 		OpenPart(nNewPart);
 		llOff.QuadPart = lAbsolutePos - llSum;
-		if (!SetFilePointerEx(m_hFile, llOff, &llNewPos, FILE_BEGIN)) {
+		if (!PartSeek(llOff, &llNewPos, FILE_BEGIN)) {
 			if (Reopen()) {
-				SetFilePointerEx(m_hFile, llOff, &llNewPos, FILE_BEGIN);
+				PartSeek(llOff, &llNewPos, FILE_BEGIN);
 			}
 		}
 
@@ -109,9 +109,9 @@ ULONGLONG CMultiFiles::GetLength()
 {
 	if (m_strFiles.size() == 1) {
 		LARGE_INTEGER llSize = {};
-		if (!GetFileSizeEx(m_hFile, &llSize)) {
+		if (!PartSize(&llSize)) {
 			if (Reopen()) {
-				GetFileSizeEx(m_hFile, &llSize);
+				PartSize(&llSize);
 			}
 		}
 		return llSize.QuadPart;
@@ -122,7 +122,7 @@ ULONGLONG CMultiFiles::GetLength()
 
 UINT CMultiFiles::Read(BYTE* lpBuf, UINT nCount, DWORD& dwError)
 {
-	if (m_hFile == INVALID_HANDLE_VALUE) {
+	if (!IsPartOpen()) {
 		dwError = ERROR_INVALID_HANDLE;
 		return 0;
 	}
@@ -134,14 +134,18 @@ UINT CMultiFiles::Read(BYTE* lpBuf, UINT nCount, DWORD& dwError)
 	do {
 		LARGE_INTEGER llNoMove = {};
 		LARGE_INTEGER llCurPos = {};
-		SetFilePointerEx(m_hFile, llNoMove, &llCurPos, FILE_CURRENT);
+		PartSeek(llNoMove, &llCurPos, FILE_CURRENT);
+		bool bReopened = false;
 
 again:
 		DWORD nNumberOfBytesRead = 0;
-		if (!ReadFile(m_hFile, lpBuf, nCount - dwRead, &nNumberOfBytesRead, nullptr)) {
-			if (Reopen(&dwError)) {
+		if (!PartRead(lpBuf, nCount - dwRead, &nNumberOfBytesRead)) {
+			if (bReopened) {
+				dwError = GetLastError();
+			} else if (Reopen(&dwError)) {
 				LARGE_INTEGER llNewPos = {};
-				if (SetFilePointerEx(m_hFile, llCurPos, &llNewPos, FILE_BEGIN) && llCurPos.QuadPart == llNewPos.QuadPart) {
+				if (PartSeek(llCurPos, &llNewPos, FILE_BEGIN) && llCurPos.QuadPart == llNewPos.QuadPart) {
+					bReopened = true;
 					goto again;
 				}
 			}
@@ -175,15 +179,22 @@ BOOL CMultiFiles::OpenPart(size_t nPart)
 		ClosePart();
 
 		const CString& lpFileName = m_strFiles[nPart];
-		m_hFile = CreateFileW(lpFileName, GENERIC_READ, FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
-		if (m_hFile != INVALID_HANDLE_VALUE) {
+		if (CDiskImageFS::IsImagePath(lpFileName)) {
+			auto pImageFile = std::make_unique<CDiskImageFile>();
+			if (pImageFile->Open(lpFileName)) {
+				m_pImageFile = std::move(pImageFile);
+			}
+		} else {
+			m_hFile = CreateFileW(lpFileName, GENERIC_READ, FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+		}
+		if (IsPartOpen()) {
 			m_nCurPart = nPart;
 			if (m_pCurrentPTSOffset) {
 				*m_pCurrentPTSOffset = m_rtPtsOffsets[nPart];
 			}
 		}
 
-		return (m_hFile != INVALID_HANDLE_VALUE);
+		return IsPartOpen();
 	}
 }
 
@@ -194,6 +205,53 @@ void CMultiFiles::ClosePart()
 		m_hFile    = INVALID_HANDLE_VALUE;
 		m_nCurPart = SIZE_T_MAX;
 	}
+	if (m_pImageFile) {
+		m_pImageFile.reset();
+		m_nCurPart = SIZE_T_MAX;
+	}
+}
+
+BOOL CMultiFiles::IsPartOpen() const
+{
+	return m_hFile != INVALID_HANDLE_VALUE || m_pImageFile;
+}
+
+BOOL CMultiFiles::PartSeek(LARGE_INTEGER llOff, LARGE_INTEGER* pNewPos, DWORD nFrom)
+{
+	if (m_pImageFile) {
+		const ULONGLONG pos = m_pImageFile->Seek(llOff.QuadPart, nFrom);
+		if (pNewPos) {
+			pNewPos->QuadPart = pos;
+		}
+		return TRUE;
+	}
+
+	return SetFilePointerEx(m_hFile, llOff, pNewPos, nFrom);
+}
+
+BOOL CMultiFiles::PartRead(BYTE* lpBuf, DWORD nCount, DWORD* pRead)
+{
+	if (m_pImageFile) {
+		*pRead = m_pImageFile->Read(lpBuf, nCount);
+		if (*pRead < nCount && m_pImageFile->GetPosition() < m_pImageFile->GetLength()) {
+			// the image read failed before the end of the part
+			SetLastError(ERROR_READ_FAULT);
+			return FALSE;
+		}
+		return TRUE;
+	}
+
+	return ReadFile(m_hFile, lpBuf, nCount, pRead, nullptr);
+}
+
+BOOL CMultiFiles::PartSize(LARGE_INTEGER* pSize)
+{
+	if (m_pImageFile) {
+		pSize->QuadPart = m_pImageFile->GetLength();
+		return TRUE;
+	}
+
+	return GetFileSizeEx(m_hFile, pSize);
 }
 
 void CMultiFiles::Reset()
@@ -232,9 +290,9 @@ LONGLONG CMultiFiles::GetAbsolutePosition(LONGLONG lOff, UINT nFrom)
 		case FILE_BEGIN :
 			return lOff;
 		case FILE_CURRENT :
-			if (!SetFilePointerEx(m_hFile, llNoMove, &llCurPos, FILE_CURRENT)) {
+			if (!PartSeek(llNoMove, &llCurPos, FILE_CURRENT)) {
 				if (Reopen()) {
-					SetFilePointerEx(m_hFile, llNoMove, &llCurPos, FILE_CURRENT);
+					PartSeek(llNoMove, &llCurPos, FILE_CURRENT);
 				}
 			}
 			return llCurPos.QuadPart + lOff;
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "DSUtil/HdmvClipInfo.h"
+#include "DSUtil/DiskImageFS.h"
 
 class CMultiFiles
 {
@@ -31,6 +32,7 @@ protected:
 
 	LONGLONG                    m_llTotalLength     = 0;
 	HANDLE                      m_hFile             = INVALID_HANDLE_VALUE;
+	std::unique_ptr<CDiskImageFile> m_pImageFile; // current part is a file inside a disc image
 	size_t                      m_nCurPart          = SIZE_T_MAX;
 	REFERENCE_TIME*             m_pCurrentPTSOffset = nullptr;
 
@@ -49,6 +51,10 @@ public:
 private:
 	BOOL     OpenPart(size_t nPart);
 	void     ClosePart();
+	BOOL     IsPartOpen() const;
+	BOOL     PartSeek(LARGE_INTEGER llOff, LARGE_INTEGER* pNewPos, DWORD nFrom);
+	BOOL     PartRead(BYTE* lpBuf, DWORD nCount, DWORD* pRead);
+	BOOL     PartSize(LARGE_INTEGER* pSize);
 	void     Reset();
 	BOOL     Reopen(DWORD* dwError = nullptr);
 	LONGLONG GetAbsolutePosition(LONGLONG lOff, UINT nFrom);
@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -259,7 +259,10 @@ STDMETHODIMP_(fraction_t) CVTSReader::GetAspectRatio()
 
 // CVTSStream
 
-CVTSStream::CVTSStream() : m_off(0)
+#define READAHEAD_SECTORS 2048 // 4 MB
+#define READAHEAD_ALIGN   32   // 64 KB
+
+CVTSStream::CVTSStream() : m_lba(0), m_off(0)
 {
 	m_ifo.reset(DNew CIfoFile());
 	m_vob.reset(DNew CVobFile());
@@ -267,20 +270,100 @@ CVTSStream::CVTSStream() : m_off(0)
 
 CVTSStream::~CVTSStream()
 {
+	WaitPrefetch();
+
+	DLogIf(m_nCacheHits + m_nCacheMisses, L"CVTSStream: read-ahead hits %I64u, misses %I64u (%.1f%% hit rate), jumps %I64u",
+		   m_nCacheHits, m_nCacheMisses, 100.0 * m_nCacheHits / (m_nCacheHits + m_nCacheMisses), m_nCacheJumps);
 }
 
 bool CVTSStream::Load(const WCHAR* fnw, bool bEnableTitleSelection)
 {
 	// TODO bEnableTitleSelection
+	WaitPrefetch();
+	m_lba = m_off = 0;
+	m_cacheCount = m_nextCount = 0;
+
 	return (m_ifo && m_vob && m_ifo->OpenIFO(fnw, 0) && m_ifo->OpenVOB(m_vob.get()));
 }
 
+int CVTSStream::ReadBlock(int start, BYTE* buff)
+{
+	if (m_vob->GetPosition() != start && m_vob->Seek(start) != start) {
+		return 0;
+	}
+
+	return m_vob->Read(buff, READAHEAD_SECTORS);
+}
+
+bool CVTSStream::FillCache(int lba)
+{
+	WaitPrefetch();
+
+	if (lba >= m_nextLBA && lba < m_nextLBA + m_nextCount) {
+		std::swap(m_cache, m_next);
+		m_cacheLBA   = m_nextLBA;
+		m_cacheCount = m_nextCount;
+	} else {
+		if (m_cache.empty()) {
+			m_cache.resize(READAHEAD_SECTORS * 2048);
+		}
+
+		// align the start of the block, but never read behind the requested sector more than necessary
+		m_cacheLBA   = lba - (lba % READAHEAD_ALIGN);
+		m_cacheCount = ReadBlock(m_cacheLBA, m_cache.data());
+	}
+	m_nextCount = 0;
+
+	if (m_cacheCount == READAHEAD_SECTORS) {
+		StartPrefetch(m_cacheLBA + m_cacheCount);
+	}
+
+	return lba >= m_cacheLBA && lba < m_cacheLBA + m_cacheCount;
+}
+
+void CVTSStream::StartPrefetch(int start)
+{
+	if (m_next.empty()) {
+		m_next.resize(READAHEAD_SECTORS * 2048);
+	}
+
+	// m_vob and m_next belong to the thread until WaitPrefetch()
+	m_nextLBA = start;
+	m_prefetchThread = std::thread([this, start] {
+		m_nextCount = ReadBlock(start, m_next.data());
+	});
+}
+
+void CVTSStream::WaitPrefetch()
+{
+	if (m_prefetchThread.joinable()) {
+		m_prefetchThread.join();
+	}
+}
+
 HRESULT CVTSStream::SetPointer(LONGLONG llPos)
 {
 	m_off = (int)(llPos & 2047);
-	int lba = (int)(llPos / 2048);
+	m_lba = (int)(llPos / 2048);
+
+	if (m_lba >= m_cacheLBA && m_lba < m_cacheLBA + m_cacheCount) {
+		return S_OK;
+	}
+
+	// the block being prefetched, FillCache() takes it
+	if (m_prefetchThread.joinable() && m_lba >= m_nextLBA && m_lba < m_nextLBA + READAHEAD_SECTORS) {
+		return S_OK;
+	}
+
+	// jump outside of the cached blocks, drop them
+	WaitPrefetch();
+	m_nextCount = 0;
+	if (m_cacheCount) {
+		m_cacheCount = 0;
+		m_nCacheJumps++;
+	}
 
-	return lba == m_vob->Seek(lba) ? S_OK : S_FALSE;
+	return m_lba == m_vob->Seek(m_lba) ? S_OK : S_FALSE;
 }
 
 HRESULT CVTSStream::Read(PBYTE pbBuffer, DWORD dwBytesToRead, BOOL bAlign, LPDWORD pdwBytesRead)
@@ -289,27 +372,36 @@ HRESULT CVTSStream::Read(PBYTE pbBuffer, DWORD dwBytesToRead, BOOL bAlign, LPDWO
 
 	DWORD len = dwBytesToRead;
 	BYTE* ptr = pbBuffer;
+	bool bHit = true;
 
 	while (len > 0) {
-		BYTE buff[2048];
-		if (!m_vob->Read(buff)) {
-			break;
+		if (m_lba < m_cacheLBA || m_lba >= m_cacheLBA + m_cacheCount) {
+			bHit = false;
+			if (!FillCache(m_lba)) {
+				break;
+			}
 		}
 
-		int size = std::min(2048 - m_off, (int)std::min(len, 2048uL));
+		const BYTE* src = m_cache.data() + 2048 * (m_lba - m_cacheLBA) + m_off;
+		const DWORD available = 2048 * (m_cacheLBA + m_cacheCount - m_lba) - m_off;
+		const DWORD size = std::min(len, available);
 
-		memcpy(ptr, &buff[m_off], size);
+		memcpy(ptr, src, size);
 
-		m_off = (m_off + size) & 2047;
-
-		if (m_off > 0) {
-			m_vob->Seek(m_vob->GetPosition() - 1);
-		}
+		const DWORD pos = m_off + size;
+		m_lba += pos / 2048;
+		m_off = pos & 2047;
 
 		ptr += size;
 		len -= size;
 	}
 
+	if (bHit) {
+		m_nCacheHits++;
+	} else {
+		m_nCacheMisses++;
+	}
+
 	if (pdwBytesRead) {
 		*pdwBytesRead = ptr - pbBuffer;
 	}
@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2023 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <thread>
 #include <ExtLib/AsyncReader/asyncio.h>
 #include <ExtLib/AsyncReader/asyncrdr.h>
 
@@ -42,7 +43,29 @@ private:
 
 	std::unique_ptr<CIfoFile> m_ifo;
 	std::unique_ptr<CVobFile> m_vob;
-	int m_off;
+	int m_lba; // current sector
+	int m_off; // offset in the current sector
+
+	// read-ahead sector cache, holds [m_cacheLBA, m_cacheLBA + m_cacheCount) sectors
+	std::vector<BYTE> m_cache;
+	int m_cacheLBA   = 0;
+	int m_cacheCount = 0;
+
+	// the following block is read in the background while the current one is consumed
+	std::vector<BYTE> m_next;
+	int m_nextLBA   = 0;
+	int m_nextCount = 0;
+	std::thread m_prefetchThread;
+
+	// statistics
+	UINT64 m_nCacheHits   = 0;
+	UINT64 m_nCacheMisses = 0;
+	UINT64 m_nCacheJumps  = 0;
+
+	int ReadBlock(int start, BYTE* buff);
+	bool FillCache(int lba);
+	void StartPrefetch(int start);
+	void WaitPrefetch();
 
 public:
 	CVTSStream();
@@ -109,6 +109,35 @@ struct pgc_t {
 
 CIfoFile::CIfoFile() = default;
 
+// IFO files are small, read them at once to avoid many small reads from the disc or image
+bool CIfoFile::LoadIFO(LPCWSTR fn, std::vector<BYTE>& data)
+{
+	data.clear();
+
+	if (CDiskImageFS::IsImagePath(fn)) {
+		if (!CDiskImageFS::ReadWholeFile(fn, data, 16 * MEGABYTE)) {
+			return false;
+		}
+	} else {
+		CFile file;
+		if (!file.Open(fn, CFile::modeRead | CFile::typeBinary | CFile::shareDenyNone)) {
+			return false;
+		}
+
+		const ULONGLONG size = file.GetLength();
+		if (size > 16 * MEGABYTE) {
+			return false;
+		}
+
+		data.resize((size_t)size);
+		if (file.Read(data.data(), (UINT)size) != size) {
+			return false;
+		}
+	}
+
+	return data.size() >= IFO_HEADER_SIZE;
+}
+
 bool CIfoFile::OpenIFO(LPCWSTR fn, ULONG nProgNum /*= 0*/)
 {
 	m_ifoFilename.SetString(fn);
@@ -116,9 +145,10 @@ bool CIfoFile::OpenIFO(LPCWSTR fn, ULONG nProgNum /*= 0*/)
 	if (m_ifoFilename.Right(6).MakeUpper() != L"_0.IFO") {
 		return false;
 	}
-	if (!m_ifoFile.Open(m_ifoFilename, CFile::modeRead | CFile::typeBinary | CFile::shareDenyNone)) {
+	if (!LoadIFO(m_ifoFilename, m_ifoData)) {
 		return false;
 	}
+	m_ifoFile.Attach(m_ifoData.data(), (UINT)m_ifoData.size());
 
 	m_bAOB = false;
 	m_pStream_Lang.clear();
@@ -468,6 +498,7 @@ bool CIfoFile::OpenIFO(LPCWSTR fn, ULONG nProgNum /*= 0*/)
 	}
 
 	m_ifoFile.Close();
+	m_ifoData.clear();
 
 	return !m_pChapters.empty();
 }
@@ -489,7 +520,10 @@ bool CIfoFile::OpenVOB(CVobFile* vobfile)
 		}
 
 		CFileStatus status;
-		if (!CFile::GetStatus(vob, status)) {
+		CDiskImageFS::Entry entry;
+		if (CDiskImageFS::GetEntry(vob, entry)) {
+			status.m_size = entry.size;
+		} else if (!CFile::GetStatus(vob, status)) {
 			break;
 		}
 
@@ -608,10 +642,11 @@ __int64 CIfoFile::GetChapterPos(UINT ChapterNumber) const
 
 bool CIfoFile::GetTitleInfo(LPCWSTR fn, ULONG nTitleNum, ULONG& VTSN, ULONG& TTN)
 {
-	CFile ifoFile;
-	if (!ifoFile.Open(fn, CFile::modeRead | CFile::typeBinary | CFile::shareDenyNone)) {
+	std::vector<BYTE> ifoData;
+	if (!LoadIFO(fn, ifoData)) {
 		return false;
 	}
+	CMemFile ifoFile(ifoData.data(), (UINT)ifoData.size());
 
 	char hdr[IFO_HEADER_SIZE + 1] = { 0 };
 	ifoFile.Read(hdr, IFO_HEADER_SIZE);
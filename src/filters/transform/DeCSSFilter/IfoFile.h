@@ -60,7 +60,9 @@ public:
 	static bool GetTitleInfo(LPCWSTR fn, ULONG nTitleNum, ULONG& VTSN /* out */, ULONG& TTN /* out */); // video_ts.ifo
 
 private:
-	CFile		m_ifoFile;
+	std::vector<BYTE> m_ifoData;
+	CMemFile	m_ifoFile;
+	static bool	LoadIFO(LPCWSTR fn, std::vector<BYTE>& data);
 	BYTE		ReadByte();
 	WORD		ReadWord();
 	DWORD		ReadDword();
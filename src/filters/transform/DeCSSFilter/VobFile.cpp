@@ -1,6 +1,6 @@
 /*
  * (C) 2003-2006 Gabest
- * (C) 2006-2025 see Authors.txt
+ * (C) 2006-2026 see Authors.txt
  *
  * This file is part of MPC-BE.
  *
@@ -324,13 +324,17 @@ CLBAFile::~CLBAFile()
 
 bool CLBAFile::IsOpen() const
 {
-	return(m_hFile != hFileNull);
+	return(m_hFile != hFileNull || m_imageFile.IsOpen());
 }
 
 bool CLBAFile::Open(LPCWSTR path)
 {
 	Close();
 
+	if (CDiskImageFS::IsImagePath(path)) {
+		return m_imageFile.Open(path);
+	}
+
 	return !!CFile::Open(path, CFile::modeRead | CFile::typeBinary | CFile::shareDenyNone | CFile::osSequentialScan);
 }
 
@@ -339,28 +343,62 @@ void CLBAFile::Close()
 	if (m_hFile != hFileNull) {
 		CFile::Close();
 	}
+	m_imageFile.Close();
 }
 
 int CLBAFile::GetLengthLBA() const
 {
+	if (m_imageFile.IsOpen()) {
+		return (int)(m_imageFile.GetLength() / 2048);
+	}
+
 	return (int)(CFile::GetLength() / 2048);
 }
 
 int CLBAFile::GetPositionLBA() const
 {
+	if (m_imageFile.IsOpen()) {
+		return (int)(m_imageFile.GetPosition() / 2048);
+	}
+
 	return (int)(CFile::GetPosition() / 2048);
 }
 
 int CLBAFile::Seek(int lba)
 {
+	if (m_imageFile.IsOpen()) {
+		return (int)(m_imageFile.Seek(2048i64 * lba, FILE_BEGIN) / 2048);
+	}
+
 	return (int)(CFile::Seek(2048i64 * lba, CFile::begin) / 2048);
 }
 
 bool CLBAFile::Read(BYTE* buff)
 {
+	if (m_imageFile.IsOpen()) {
+		return m_imageFile.Read(buff, 2048) == 2048;
+	}
+
 	return CFile::Read(buff, 2048) == 2048;
 }
 
+int CLBAFile::Read(BYTE* buff, int count)
+{
+	const int lba = GetPositionLBA();
+
+	const UINT len = m_imageFile.IsOpen()
+					 ? m_imageFile.Read(buff, 2048 * count)
+					 : CFile::Read(buff, 2048 * count);
+
+	// a short read must not leave the position inside a sector
+	const int read = (int)(len / 2048);
+	if (len & 2047) {
+		Seek(lba + read);
+	}
+
+	return read;
+}
+
 //
 // CVobFile
 //
@@ -383,25 +421,36 @@ bool CVobFile::OpenVOBs(const std::list<CStringW>& vobs)
 		return false;
 	}
 
+	bool bImage = false;
+
 	for (const auto& fn : vobs) {
+		__int64 size = 0;
 
-		WIN32_FIND_DATA fd;
-		HANDLE h = FindFirstFileW(fn, &fd);
-		if (h == INVALID_HANDLE_VALUE) {
-			m_files.clear();
-			return false;
+		CDiskImageFS::Entry entry;
+		if (CDiskImageFS::GetEntry(fn, entry)) {
+			size = entry.size;
+			bImage = true;
+		} else {
+			WIN32_FIND_DATA fd;
+			HANDLE h = FindFirstFileW(fn, &fd);
+			if (h == INVALID_HANDLE_VALUE) {
+				m_files.clear();
+				return false;
+			}
+			FindClose(h);
+			size = (__int64(fd.nFileSizeHigh) << 32) | fd.nFileSizeLow;
 		}
-		FindClose(h);
 
 		file_t f;
 		f.fn = fn;
-		f.size = (int)(((__int64(fd.nFileSizeHigh) << 32) | fd.nFileSizeLow) / 2048);
+		f.size = (int)(size / 2048);
 		m_files.push_back(f);
 
 		m_size += f.size;
 	}
 
-	if (m_files.size() > 0 && CDVDSession::Open(m_files[0].fn)) {
+	// CSS keys are not available for disc images
+	if (m_files.size() > 0 && !bImage && CDVDSession::Open(m_files[0].fn)) {
 		for (size_t i = 0; !m_fHasTitleKey && i < m_files.size(); i++) {
 			if (BeginSession()) {
 				m_fDVD = true;
@@ -536,43 +585,55 @@ int CVobFile::Seek(int pos)
 
 bool CVobFile::Read(BYTE* buff)
 {
-	if (m_pos >= m_size) {
-		return false;
-	}
+	return Read(buff, 1) == 1;
+}
 
-	if (m_file.IsOpen() && m_file.GetPositionLBA() == m_file.GetLengthLBA()) {
-		m_file.Close();
-	}
+int CVobFile::Read(BYTE* buff, int count)
+{
+	int read = 0;
 
-	if (!m_file.IsOpen()) {
-		if (m_iFile >= (int)m_files.size() - 1) {
-			return false;
+	while (read < count && m_pos < m_size) {
+		if (m_file.IsOpen() && m_file.GetPositionLBA() == m_file.GetLengthLBA()) {
+			m_file.Close();
 		}
 
-		if (!m_file.Open(m_files[++m_iFile].fn)) {
-			m_iFile = -1;
-			return false;
+		if (!m_file.IsOpen()) {
+			if (m_iFile >= (int)m_files.size() - 1) {
+				break;
+			}
+
+			if (!m_file.Open(m_files[++m_iFile].fn)) {
+				m_iFile = -1;
+				break;
+			}
 		}
-	}
 
-	if (!m_file.Read(buff)) {
-		// dvd still locked?
-		return false;
-	}
+		const int n = std::min({ count - read, m_size - m_pos, m_file.GetLengthLBA() - m_file.GetPositionLBA() });
+		const int r = m_file.Read(buff + 2048 * read, n);
 
-	m_pos++;
+		for (int i = 0; i < r; i++) {
+			BYTE* sector = buff + 2048 * (read + i);
+			if (sector[0x14] & 0x30) {
+				if (m_fHasTitleKey) {
+					CSSdescramble(sector, m_TitleKey);
+					sector[0x14] &= ~0x30;
+				} else {
+					// under win9x this is normal, but I'm not developing under win9x :P
+					ASSERT(0);
+				}
+			}
+		}
 
-	if (buff[0x14] & 0x30) {
-		if (m_fHasTitleKey) {
-			CSSdescramble(buff, m_TitleKey);
-			buff[0x14] &= ~0x30;
-		} else {
-			// under win9x this is normal, but I'm not developing under win9x :P
-			ASSERT(0);
+		m_pos += r;
+		read += r;
+
+		if (r < n) {
+			// dvd still locked?
+			break;
 		}
 	}
 
-	return true;
+	return read;
 }
 
 bool CVobFile::IsDVD() const
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <winddk/ntddcdvd.h>
+#include "DSUtil/DiskImageFS.h"
 
 // CDVDSession
 
@@ -72,6 +73,10 @@ public:
 	int GetPositionLBA() const;
 	int Seek(int lba);
 	bool Read(BYTE* buff);
+	int Read(BYTE* buff, int count); // returns the number of sectors read
+
+private:
+	CDiskImageFile m_imageFile; // used when the file is inside a disc image
 };
 
 // CVobFile
@@ -108,6 +113,7 @@ public:
 	int GetPosition() const;
 	int Seek(int pos);
 	bool Read(BYTE* buff);
+	int Read(BYTE* buff, int count); // reads up to count sectors across the vob files, returns the number of sectors read
 
 	bool IsDVD() const;
 	bool HasDiscKey(BYTE* key) const;